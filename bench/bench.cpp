@@ -0,0 +1,1296 @@
+// Banc de mesure et de non-régression des noyaux DSP, hors de Rack.
+//
+//   make bench                 mesures + vérifications
+//   make bench-golden          enregistre les traces de référence dans bench/golden
+//
+// Options : --record DIR, --golden DIR, --no-timing, --samples N
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "filtres.hpp"
+#include "bruits.hpp"
+#include "compression.hpp"
+#include "ensemble.hpp"
+#include "mesures.hpp"
+#include "gammes.hpp"
+#include "statistiques.hpp"
+#include "occupation.hpp"
+
+using rack::simd::float_4;
+
+static const float SAMPLE_RATE = 44100.f;
+static const float SAMPLE_TIME = 1.f / SAMPLE_RATE;
+
+static const char* FILTER_NAMES[] = {"none", "diode", "rubber", "multi-well"};
+static const char* INTEGRATOR_NAMES[] = {"euler", "heun", "rk4", "semi-implicit"};
+static const char* POTENTIAL_NAMES[] = {"multi-well", "asymmetric", "tristable", "washboard"};
+
+// Générateur congruentiel pour des entrées reproductibles
+struct Lcg {
+    uint32_t state;
+    explicit Lcg(uint32_t seed) : state(seed) {}
+    float uniform() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.f / 16777216.f) * 2.f - 1.f;
+    }
+};
+
+// Entrée de test : sinus lent + bruit uniforme
+struct TestInput {
+    std::vector<float> signal, noise;
+    TestInput(int n, float amplitude, float noiseLevel, uint32_t seed) : signal(n), noise(n) {
+        Lcg lcg(seed);
+        for (int i = 0; i < n; ++i) {
+            signal[i] = amplitude * std::sin(2.f * (float)M_PI * 5.f * i * SAMPLE_TIME);
+            noise[i] = noiseLevel * lcg.uniform();
+        }
+    }
+};
+
+static volatile float sink;
+
+// Durée moyenne d'un appel de f, en ns
+static double timeIt(int iterations, const std::function<void(int)>& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// === Mesures ===
+
+static void benchRS(int samples) {
+    TestInput in(samples, 1.f, 1.f, 1);
+    std::printf("\n== RSModule (ns/sample mono, ns/channel float_4)\n");
+    std::printf("%-12s %-14s %4s %10s %10s\n", "filter", "integrator", "N", "mono", "float_4");
+
+    for (int filter = FILTER_DIODE; filter <= FILTER_MULTI_WELL; ++filter) {
+        int methods = (filter == FILTER_MULTI_WELL) ? INTEGRATORS_LEN : 1;
+        int maxN = (filter == FILTER_MULTI_WELL) ? 16 : 1;
+        for (int method = 0; method < methods; ++method) {
+            for (int N = 1; N <= maxN; ++N) {
+                float tau = 1.f / 10.f;
+                MultiWellCoefs<float> k1(N, 1.f);
+                MultiWellCoefs<float_4> k4(N, float_4(1.f));
+                float h = SAMPLE_TIME / tau;
+                float g = multi_well_noise_gain(SAMPLE_TIME, tau);
+
+                float x1 = -1.f;
+                double mono = timeIt(samples, [&](int i) {
+                    sink = rsProcess_simd<float>(filter, method, x1, in.signal[i], in.noise[i], 1.f, h, g, k1);
+                });
+                float_4 x4 = -1.f;
+                double poly = timeIt(samples, [&](int i) {
+                    float_4 out = rsProcess_simd<float_4>(filter, method, x4, float_4(in.signal[i]), float_4(in.noise[i]),
+                        float_4(1.f), float_4(h), float_4(g), k4);
+                    sink = out[0];
+                }) / 4.0;
+                std::printf("%-12s %-14s %4d %10.2f %10.2f\n", FILTER_NAMES[filter],
+                    filter == FILTER_MULTI_WELL ? INTEGRATOR_NAMES[method] : "-", N, mono, poly);
+            }
+        }
+    }
+}
+
+static void benchNoise(int samples) {
+    std::printf("\n== Noise (ns/sample)\n");
+    std::printf("%-12s %10s %10s\n", "", "mono", "16 ch");
+    GaussianGenerator rng(1);
+    float redLast = 0.f;
+    VelvetState velvetState;
+    float_4 redLast4[4] = {};
+    VelvetState velvetStates[16];
+    Perlin perlin;
+    double mono, poly;
+
+    mono = timeIt(samples, [&](int) { sink = generateWhiteNoise(rng); });
+    poly = timeIt(samples, [&](int) {
+        for (int c = 0; c < 16; c += 4)
+            sink = generateWhiteNoise_simd(rng)[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "white", mono, poly);
+
+    mono = timeIt(samples, [&](int) { sink = generateRedNoise(rng, redLast); });
+    poly = timeIt(samples, [&](int) {
+        for (int c = 0; c < 16; c += 4)
+            sink = generateRedNoise_simd(rng, redLast4[c / 4])[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "red", mono, poly);
+
+    mono = timeIt(samples, [&](int) { sink = generateVelvetNoise(VELVET_DENSITY, SAMPLE_TIME, rng, velvetState); });
+    poly = timeIt(samples, [&](int) {
+        for (int c = 0; c < 16; c += 4)
+            sink = generateVelvetNoise_simd(VELVET_DENSITY, SAMPLE_TIME, rng, &velvetStates[c])[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "velvet", mono, poly);
+
+    VelvetSequence sequence;
+    VelvetFir<float> fir;
+    VelvetFir<float_4> fir4[4];
+    sequence.generate(SAMPLE_RATE / 10, VELVET_DENSITY, SAMPLE_RATE, 1);
+    fir.setLength(sequence.length);
+    for (int c = 0; c < 4; ++c)
+        fir4[c].setLength(sequence.length);
+    mono = timeIt(samples, [&](int) { sink = fir.process(sequence, 0, rng.gaussian()); });
+    poly = timeIt(samples, [&](int) {
+        for (int c = 0; c < 16; c += 4)
+            sink = fir4[c / 4].process(sequence, c, rng.gaussian4())[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "velvet fir", mono, poly);
+
+    ColoredNoiseFilter colorFilter;
+    ColoredNoise<float> colored;
+    ColoredNoise<float_4> colored4[4];
+    mono = timeIt(samples, [&](int) { sink = colored.process(colorFilter, rng.gaussian()); });
+    poly = timeIt(samples, [&](int) {
+        for (int c = 0; c < 16; c += 4)
+            sink = colored4[c / 4].process(colorFilter, rng.gaussian4())[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "colored", mono, poly);
+
+    mono = timeIt(samples, [&](int i) { sink = perlin.sample(i * (10.0 / SAMPLE_RATE)); });
+    poly = timeIt(samples, [&](int i) {
+        for (int c = 0; c < 16; c += 4)
+            sink = perlin.sample_simd(i * (10.0 / SAMPLE_RATE), c)[0];
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "perlin", mono, poly);
+}
+
+static void benchCompressor(int samples) {
+    TestInput in(samples, 2.f, 0.5f, 2);
+    std::printf("\n== Compressor (ns/sample)\n");
+    std::printf("%-12s %10s %10s\n", "", "mono", "16 ch");
+    const char* detectors[] = {"peak", "rms"};
+    for (int d = 0; d < DETECTOR_MODES_LEN; ++d) {
+        CompressorSettings settings;
+        settings.detector = d;
+        settings.setTimes(0.005f, 0.1f, SAMPLE_RATE);
+        CompressorState<float> state;
+        CompressorState<float_4> states[4];
+        double mono = timeIt(samples, [&](int i) {
+            sink = state.process(settings, in.signal[i] + in.noise[i]);
+        });
+        double poly = timeIt(samples, [&](int i) {
+            float_4 x = in.signal[i] + in.noise[i];
+            for (int c = 0; c < 16; c += 4)
+                sink = states[c / 4].process(settings, x)[0];
+        });
+        std::printf("%-12s %10.2f %10.2f\n", detectors[d], mono, poly);
+    }
+
+    // 4 bandes : séparation et compression d'un canal dans un float_4
+    CompressorSettings settings;
+    settings.setTimes(0.005f, 0.1f, SAMPLE_RATE);
+    CrossoverCoefs crossover;
+    crossover.set(4, 200.f, 1000.f, 5000.f, SAMPLE_RATE);
+    CrossoverState xover[16];
+    CompressorState<float_4> bands[16];
+    double mono = timeIt(samples, [&](int i) {
+        float_4 y = bands[0].process(settings, xover[0].process(crossover, in.signal[i] + in.noise[i]));
+        sink = y[0] + y[1] + y[2] + y[3];
+    });
+    double poly = timeIt(samples, [&](int i) {
+        for (int c = 0; c < 16; ++c) {
+            float_4 y = bands[c].process(settings, xover[c].process(crossover, in.signal[i] + in.noise[i]));
+            sink = y[0] + y[1] + y[2] + y[3];
+        }
+    });
+    std::printf("%-12s %10.2f %10.2f\n", "4 bands", mono, poly);
+}
+
+static const char* ANTIALIASING_NAMES[] = {"none", "adaa1", "adaa2", "oversample2", "oversample4"};
+
+// Sortie d'un filtre à seuil avec le mode d'anti-repliement donné
+struct ThresholdRunner {
+    int filter, mode;
+    ThresholdAdaa<float_4> adaa;
+    ThresholdOversampler<float_4> oversampler;
+    OversamplingFilter oversampling;
+
+    ThresholdRunner(int filter, int mode) : filter(filter), mode(mode) {
+        oversampling.setFactor(mode == ANTIALIASING_OVERSAMPLE4 ? 4 : 2);
+    }
+
+    float_4 process(float_4 x, float_4 th) {
+        switch (mode) {
+            case ANTIALIASING_ADAA1: return adaa.process1(filter, x, th);
+            case ANTIALIASING_ADAA2: return adaa.process2(filter, x, th);
+            case ANTIALIASING_OVERSAMPLE2:
+            case ANTIALIASING_OVERSAMPLE4: return oversampler.process(oversampling, filter, x, th);
+            default: return threshold_shape_simd(filter, x, th);
+        }
+    }
+};
+
+static void benchAntialiasing(int samples) {
+    TestInput in(samples, 5.f, 0.5f, 7);
+    std::printf("\n== Threshold anti-aliasing, rubber (ns/sample)\n");
+    std::printf("%-12s %10s %10s\n", "", "float_4", "16 ch");
+    for (int mode = 0; mode < ANTIALIASING_MODES_LEN; ++mode) {
+        ThresholdRunner runners[4] = {
+            ThresholdRunner(FILTER_RUBBER, mode), ThresholdRunner(FILTER_RUBBER, mode),
+            ThresholdRunner(FILTER_RUBBER, mode), ThresholdRunner(FILTER_RUBBER, mode)};
+        double one = timeIt(samples, [&](int i) {
+            sink = runners[0].process(in.signal[i] + in.noise[i], 1.f)[0];
+        });
+        double poly = timeIt(samples, [&](int i) {
+            for (int g = 0; g < 4; ++g)
+                sink = runners[g].process(in.signal[i] + in.noise[i], 1.f)[0];
+        });
+        std::printf("%-12s %10.2f %10.2f\n", ANTIALIASING_NAMES[mode], one, poly);
+    }
+}
+
+static void benchEnsemble(int samples) {
+    TestInput in(samples, 0.3f, 0.5f, 4);
+    float tau = 1.f / 300.f;
+    float h = SAMPLE_TIME / tau, g = multi_well_noise_gain(SAMPLE_TIME, tau);
+    MultiWellCoefs<float> k(2, 1.f);
+    PotentialKernel<float_4> euler = potential_kernel<float_4>(POTENTIAL_MULTI_WELL, k.N, INTEGRATOR_EULER);
+    std::printf("\n== Ensemble, multi-well N=2 euler (ns/sample, one channel)\n");
+    std::printf("%-12s %10s %10s %10s\n", "units", "none", "ring", "global");
+    const int sizes[] = {4, 16, 64};
+    for (int units : sizes) {
+        double t[COUPLINGS_LEN];
+        for (int coupling = 0; coupling < COUPLINGS_LEN; ++coupling) {
+            RSEnsemble ensemble;
+            ensemble.seed(1);
+            t[coupling] = timeIt(samples, [&](int i) {
+                sink = ensemble.process(FILTER_MULTI_WELL, euler, units, coupling, 1.f, 1.f,
+                    in.signal[i], in.noise[i], 1.f, h, g, k);
+            });
+        }
+        std::printf("%-12d %10.2f %10.2f %10.2f\n", units, t[0], t[1], t[2]);
+    }
+}
+
+static void benchPotentials(int samples) {
+    TestInput in(samples, 1.f, 1.f, 8);
+    float tau = 1.f / 10.f;
+    float h = SAMPLE_TIME / tau, g = multi_well_noise_gain(SAMPLE_TIME, tau);
+    MultiWellCoefs<float_4> k(4, float_4(1.f));
+    k.setAsymmetry(0.5f);
+    std::printf("\n== Potential shapes, N=4 (ns/channel float_4)\n");
+    std::printf("%-12s", "");
+    for (int method = 0; method < INTEGRATORS_LEN; ++method)
+        std::printf(" %14s", INTEGRATOR_NAMES[method]);
+    std::printf("\n");
+    for (int shape = 0; shape < POTENTIAL_SHAPES_LEN; ++shape) {
+        std::printf("%-12s", POTENTIAL_NAMES[shape]);
+        for (int method = 0; method < INTEGRATORS_LEN; ++method) {
+            float_4 x = -1.f;
+            PotentialKernel<float_4> step = potential_kernel<float_4>(shape, k.N, method);
+            double t = timeIt(samples, [&](int i) {
+                float_4 out = rsProcess_simd<float_4>(FILTER_MULTI_WELL, step, x, float_4(in.signal[i]),
+                    float_4(in.noise[i]), float_4(1.f), float_4(h), float_4(g), k);
+                sink = out[0];
+            }) / 4.0;
+            std::printf(" %14.2f", t);
+        }
+        std::printf("\n");
+    }
+}
+
+static void benchOccupancy(int samples) {
+    TestInput in(samples, 1.f, 1.f, 9);
+    OccupancyHistogram occupancy;
+    occupancy.setTimeConstant(SAMPLE_TIME, 2.f);
+    occupancy.setRange(-9.f, 9.f);
+    EscapeRate<float_4> escapes;
+    escapes.setTimeConstant(SAMPLE_TIME, 2.f);
+    MultiWellCoefs<float_4> k(4, float_4(1.f));
+    std::printf("\n== Occupancy histogram and escape rate (ns/sample)\n");
+    double t = timeIt(samples, [&](int i) {
+        float_4 x = in.signal[i] + in.noise[i];
+        float_4 w = potential_index_simd(POTENTIAL_MULTI_WELL, x, k);
+        escapes.process(w);
+        occupancy.process(x[0], (int)w[0]);
+    });
+    std::printf("%-12s %10.2f\n", "float_4", t);
+}
+
+// === Vérifications ===
+
+static int failures = 0;
+
+// value : erreur maximale ou grandeur mesurée, selon la vérification
+static void check(bool ok, const std::string& what, double value) {
+    std::printf("%-48s %-4s (value %.3g)\n", what.c_str(), ok ? "ok" : "FAIL", value);
+    if (!ok) failures++;
+}
+
+// Noyaux directs contre noyaux de référence.
+// Aux frontières entre puits, l'arrondi de x0 ± Xb laisse dans la référence
+// des trous d'un ulp où elle retourne 0 : ces points sont écartés.
+static void checkKernels() {
+    double errGrad = 0.0, errPot = 0.0;
+    for (int N = 1; N <= 16; ++N) {
+        for (float Xb = 0.1f; Xb <= 10.f; Xb *= 1.5f) {
+            for (int i = -2000; i <= 2000; ++i) {
+                float x = i * 0.0025f * N * Xb;
+                float u = x / (2.f * Xb) + (N - 1) / 2.f + 0.5f;
+                if (std::fabs(u - std::round(u)) < 1e-4f) continue;
+                float g = multi_well_grad(x, N, Xb), gr = multi_well_grad_ref(x, N, Xb);
+                float p = multi_well_potential(x, N, Xb), pr = multi_well_potential_ref(x, N, Xb);
+                errGrad = std::fmax(errGrad, std::fabs(g - gr) / (1.0 + std::fabs(gr)));
+                errPot = std::fmax(errPot, std::fabs(p - pr) / (1.0 + std::fabs(pr)));
+            }
+        }
+    }
+    check(errGrad < 1e-4, "multi_well_grad vs reference", errGrad);
+    check(errPot < 1e-4, "multi_well_potential vs reference", errPot);
+}
+
+// Potentiel multi-puits à N lu à l'exécution, comme avant la spécialisation
+struct RuntimeMultiWell {
+    template <typename T>
+    static T grad(T x, const MultiWellCoefs<T>& k) {
+        return multi_well_grad_simd(x, k);
+    }
+
+    template <typename T>
+    static T curvature(T x, const MultiWellCoefs<T>& k) {
+        return multi_well_curvature_simd(x, k);
+    }
+};
+
+// Noyaux à N fixé contre noyau à N variable, puis pour chaque forme : gradient
+// et courbure contre différences finies du potentiel, fond de chaque puits
+// dans le puits de même indice.
+static void checkPotentials() {
+    double errFixed = 0.0;
+    for (int N = 1; N <= 16; ++N) {
+        MultiWellCoefs<float> k(N, 0.7f);
+        for (int method = 0; method < INTEGRATORS_LEN; ++method) {
+            for (int i = -4000; i <= 4000; ++i) {
+                float x = i * 0.003f * N;
+                float a = multiWellStep_simd(method, x, 0.3f, 0.7f, 0.05f, 0.2f, k);
+                float b = potentialStep_simd<RuntimeMultiWell>(method, x, 0.3f, 0.7f, 0.05f, 0.2f, k);
+                errFixed = std::fmax(errFixed, std::fabs(a - b) / (1.0 + std::fabs(b)));
+                errFixed = std::fmax(errFixed, std::fabs(potential_index_simd(POTENTIAL_MULTI_WELL, x, k) - well_index_simd(x, k)));
+            }
+        }
+    }
+    // Heun et RK4 : l'ordre des opérations peut changer d'une instanciation à l'autre
+    check(errFixed < 1e-4, "fixed-N multi-well kernels vs runtime N", errFixed);
+
+    const float d = 1e-2f;
+    for (int shape = 0; shape < POTENTIAL_SHAPES_LEN; ++shape) {
+        double errGrad = 0.0, errCurv = 0.0;
+        int wrongWell = 0;
+        for (float Xb = 0.5f; Xb <= 4.f; Xb *= 2.f) {
+            MultiWellCoefs<float> k(5, Xb);
+            k.setAsymmetry(0.4f);
+            for (int i = -1000; i <= 1000; ++i) {
+                float x = i * 0.004f * 5.f * Xb;
+                float gr = 0.f, cu = 0.f, dg, dc;
+                switch (shape) {
+                    case POTENTIAL_MULTI_WELL: gr = MultiWellPotential<5>::grad(x, k); cu = MultiWellPotential<5>::curvature(x, k); break;
+                    case POTENTIAL_ASYMMETRIC: gr = AsymmetricPotential::grad(x, k); cu = AsymmetricPotential::curvature(x, k); break;
+                    case POTENTIAL_TRISTABLE: gr = TristablePotential::grad(x, k); cu = TristablePotential::curvature(x, k); break;
+                    case POTENTIAL_WASHBOARD: gr = WashboardPotential::grad(x, k); cu = WashboardPotential::curvature(x, k); break;
+                }
+                dg = (potential_simd(shape, x + d * Xb, k) - potential_simd(shape, x - d * Xb, k)) / (2.f * d * Xb);
+                // Courbure : différence du gradient, par le pas du filtre (h = 1, bruit nul)
+                float gp = potentialStepDispatch_simd(shape, INTEGRATOR_EULER, x + d * Xb, 0.f, 0.f, 1.f, 0.f, k) - (x + d * Xb);
+                float gm = potentialStepDispatch_simd(shape, INTEGRATOR_EULER, x - d * Xb, 0.f, 0.f, 1.f, 0.f, k) - (x - d * Xb);
+                dc = (gm - gp) / (2.f * d * Xb);
+                double scale = 1.0 + std::fabs(gr) + Xb;
+                errGrad = std::fmax(errGrad, std::fabs(gr - dg) / scale);
+                errCurv = std::fmax(errCurv, std::fabs(cu - dc) / (1.0 + std::fabs(cu)));
+            }
+            // Descente sans bruit depuis un point proche de chaque fond de puits
+            for (int w = 0; w < potential_wells(shape, k.N); ++w) {
+                float x = 0.f;
+                switch (shape) {
+                    case POTENTIAL_MULTI_WELL: x = (w - k.c) * k.L; break;
+                    case POTENTIAL_ASYMMETRIC: x = w ? Xb * 1.4f : -Xb * 0.6f; break;
+                    case POTENTIAL_TRISTABLE: x = (w - 1) * Xb; break;
+                    case POTENTIAL_WASHBOARD: x = (w - 8) * k.L; break;
+                }
+                x += 0.1f * Xb;
+                for (int n = 0; n < 200; ++n)
+                    x = potentialStepDispatch_simd(shape, INTEGRATOR_SEMI_IMPLICIT, x, 0.f, 0.f, 0.5f, 0.f, k);
+                if ((int)potential_index_simd(shape, x, k) != w || std::fabs(potentialStepDispatch_simd(
+                        shape, INTEGRATOR_EULER, x, 0.f, 0.f, 1.f, 0.f, k) - x) > 1e-3f * Xb)
+                    wrongWell++;
+            }
+        }
+        std::string name = POTENTIAL_NAMES[shape];
+        check(errGrad < 1e-3, name + " gradient vs potential", errGrad);
+        check(errCurv < 1e-2, name + " curvature vs gradient", errCurv);
+        check(wrongWell == 0, name + " well minima and indices", wrongWell);
+    }
+}
+
+// Chaque voie float_4 doit suivre le chemin scalaire, pas à pas depuis le même état.
+// Pour Heun et RK4 le nombre de sous-pas dépend des quatre voies, d'où une tolérance.
+static void checkSimdLanes() {
+    const int n = 4096;
+    TestInput in(n, 1.f, 1.f, 3);
+    const int N = 5;
+    float Xb[4] = {0.5f, 1.f, 1.5f, 2.f};
+    float tau[4] = {0.1f, 0.05f, 0.01f, 0.002f};
+    float_4 tau4 = float_4::load(tau);
+    MultiWellCoefs<float_4> k4(N, float_4::load(Xb));
+
+    for (int filter = FILTER_DIODE; filter <= FILTER_MULTI_WELL; ++filter) {
+        int methods = (filter == FILTER_MULTI_WELL) ? INTEGRATORS_LEN : 1;
+        for (int method = 0; method < methods; ++method) {
+            float_4 x4 = -1.f;
+            double err = 0.0;
+            for (int i = 0; i < n; ++i) {
+                float_4 prev = x4;
+                float_4 out = rsProcess_simd<float_4>(filter, method, x4, float_4(in.signal[i]), float_4(in.noise[i]),
+                    float_4(1.f), SAMPLE_TIME / tau4, multi_well_noise_gain(SAMPLE_TIME, tau4), k4);
+                for (int l = 0; l < 4; ++l) {
+                    float x = prev[l];
+                    MultiWellCoefs<float> k1(N, Xb[l]);
+                    float ref = rsProcess_simd<float>(filter, method, x, in.signal[i], in.noise[i], 1.f,
+                        SAMPLE_TIME / tau[l], multi_well_noise_gain(SAMPLE_TIME, tau[l]), k1);
+                    err = std::fmax(err, std::fabs(out[l] - ref) / (1.0 + std::fabs(ref)));
+                }
+            }
+            std::string name = std::string("float_4 lanes, ") + FILTER_NAMES[filter];
+            if (filter == FILTER_MULTI_WELL) name += std::string(" ") + INTEGRATOR_NAMES[method];
+            check(err < 1e-4, name, err);
+        }
+    }
+}
+
+// Moments de la gaussienne par blocs : moyenne 0, variance 1, kurtosis 3
+static void checkGaussian() {
+    GaussianGenerator rng(7);
+    const int n = 1 << 20;
+    double m1 = 0, m2 = 0, m4 = 0;
+    for (int i = 0; i < n; ++i) {
+        double g = rng.gaussian();
+        m1 += g;
+        m2 += g * g;
+        m4 += g * g * g * g;
+    }
+    m1 /= n;
+    m2 /= n;
+    m4 /= n;
+    check(std::fabs(m1) < 5e-3, "gaussian mean", std::fabs(m1));
+    check(std::fabs(m2 - 1.0) < 1e-2, "gaussian variance", std::fabs(m2 - 1.0));
+    check(std::fabs(m4 - 3.0) < 5e-2, "gaussian kurtosis", std::fabs(m4 - 3.0));
+}
+
+// Canaux polyphoniques du bruit : chaque voie du Perlin reproduit la version
+// mono de son canal, et les corrélations entre canaux restent au niveau du hasard
+static void checkNoiseChannels() {
+    Perlin perlin(5);
+    double err = 0.0;
+    for (int i = 0; i < 4096; ++i) {
+        double phase = i * (10.0 / SAMPLE_RATE);
+        for (int c = 0; c < 16; c += 4) {
+            float_4 v = perlin.sample_simd(phase, c);
+            for (int l = 0; l < 4; ++l)
+                err = std::fmax(err, std::fabs(v[l] - perlin.sample(phase, c + l)));
+        }
+    }
+    check(err < 1e-6, "perlin lanes vs mono", err);
+
+    // Bouclage de la phase sans raccord, et résolution intacte en fin de période
+    double seam = std::fabs(perlin.sample(Perlin::advance(Perlin::PERIOD - 1e-7, 2e-7)) - perlin.sample(1e-7));
+    double late = 0.0;
+    for (int i = 1; i <= 64; ++i) {
+        double d = perlin.sample(Perlin::PERIOD - 1.0 + i * 1e-4) - perlin.sample(Perlin::PERIOD - 1.0 + (i - 1) * 1e-4);
+        late = std::fmax(late, std::fabs(d));
+    }
+    check(seam < 1e-5, "perlin phase wrap", seam);
+    check(late > 0.0 && late < 1e-2, "perlin resolution at end of period", late);
+
+    const int n = 1 << 16;
+    GaussianGenerator rng(3);
+    std::vector<float> white(16 * n), smooth(16 * n);
+    for (int i = 0; i < n; ++i) {
+        for (int c = 0; c < 16; c += 4) {
+            generateWhiteNoise_simd(rng).store(&white[16 * i + c]);
+            // Perlin à 200 Hz : environ 300 cellules du réseau sur la durée
+            perlin.sample_simd(i * (200.0 / SAMPLE_RATE), c).store(&smooth[16 * i + c]);
+        }
+    }
+    auto maxCorrelation = [&](const std::vector<float>& v) {
+        double worst = 0.0;
+        for (int a = 0; a < 16; ++a) {
+            for (int b = a + 1; b < 16; ++b) {
+                double ab = 0, aa = 0, bb = 0;
+                for (int i = 0; i < n; ++i) {
+                    ab += v[16 * i + a] * v[16 * i + b];
+                    aa += v[16 * i + a] * v[16 * i + a];
+                    bb += v[16 * i + b] * v[16 * i + b];
+                }
+                worst = std::fmax(worst, std::fabs(ab) / std::sqrt(aa * bb + 1e-30));
+            }
+        }
+        return worst;
+    };
+    double cw = maxCorrelation(white);
+    check(cw < 0.03, "white channel correlation", cw);
+    double cp = maxCorrelation(smooth);
+    check(cp < 0.3, "perlin channel correlation", cp);
+}
+
+// Bruit coloré : pente de la réponse en puissance ajustée sur 40 Hz - 4 kHz,
+// écart à la droite, et variance unité en sortie
+static void checkColoredNoise() {
+    const float alphas[] = {0.f, 0.5f, 1.f, 1.5f, 2.f};
+    for (float alpha : alphas) {
+        ColoredNoiseFilter f;
+        f.setSlope(alpha, SAMPLE_RATE);
+
+        const int points = 64;
+        std::vector<double> lx(points), ly(points);
+        for (int i = 0; i < points; ++i) {
+            double freq = 40.0 * std::pow(100.0, i / (points - 1.0));
+            double w = 2.0 * M_PI * freq / SAMPLE_RATE;
+            std::complex<double> z = std::polar(1.0, -w);
+            std::complex<double> h = f.direct;
+            for (int k = 0; k < ColoredNoiseFilter::POLES; ++k)
+                h += (double)f.w[k] * (double)f.b[k] / (1.0 - (1.0 - (double)f.b[k]) * z);
+            lx[i] = std::log10(freq);
+            ly[i] = 10.0 * std::log10(std::norm(h));
+        }
+        double mx = 0, my = 0, sxy = 0, sxx = 0;
+        for (int i = 0; i < points; ++i) {
+            mx += lx[i] / points;
+            my += ly[i] / points;
+        }
+        for (int i = 0; i < points; ++i) {
+            sxy += (lx[i] - mx) * (ly[i] - my);
+            sxx += (lx[i] - mx) * (lx[i] - mx);
+        }
+        double slope = sxy / sxx; // dB par décade : -10 alpha
+        double ripple = 0.0;
+        for (int i = 0; i < points; ++i)
+            ripple = std::fmax(ripple, std::fabs(ly[i] - my - slope * (lx[i] - mx)));
+        char name[64];
+        std::snprintf(name, sizeof(name), "colored alpha %.1f slope", alpha);
+        check(std::fabs(-slope / 10.0 - alpha) < 0.05, name, std::fabs(-slope / 10.0 - alpha));
+        std::snprintf(name, sizeof(name), "colored alpha %.1f ripple (dB)", alpha);
+        check(ripple < 1.0, name, ripple);
+
+        GaussianGenerator rng(11);
+        ColoredNoise<float> noise;
+        double var = 0.0;
+        const int n = 1 << 20;
+        for (int i = 0; i < n; ++i) {
+            double y = noise.process(f, rng.gaussian());
+            var += y * y / n;
+        }
+        std::snprintf(name, sizeof(name), "colored alpha %.1f variance", alpha);
+        check(std::fabs(var - 1.0) < 0.1, name, std::fabs(var - 1.0));
+    }
+}
+
+// Velvet noise : nombre d'impulsions conforme à la densité, positions non
+// périodiques. FIR velvet : réponse impulsionnelle éparse de ±gain, d'énergie
+// unité, sortie identique à la convolution dense par cette réponse, réponses
+// décorrélées d'un canal à l'autre, et voies float_4 égales aux canaux seuls.
+static void checkVelvet() {
+    GaussianGenerator rng(13);
+    VelvetState state;
+    const float densities[] = {100.f, 1000.f, 5000.f};
+    for (float density : densities) {
+        int pulses = 0, last = -1, minGap = 1 << 30, maxGap = 0;
+        for (int i = 0; i < (int)SAMPLE_RATE; ++i) {
+            if (generateVelvetNoise(density, SAMPLE_TIME, rng, state) != 0.f) {
+                if (last >= 0) {
+                    minGap = std::min(minGap, i - last);
+                    maxGap = std::max(maxGap, i - last);
+                }
+                last = i;
+                pulses++;
+            }
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "velvet %.0f/s pulse count", density);
+        check(std::abs(pulses - (int)density) <= 1, name, std::abs(pulses - (int)density));
+        float period = SAMPLE_RATE / density;
+        std::snprintf(name, sizeof(name), "velvet %.0f/s random positions", density);
+        check(minGap < 0.5f * period && maxGap > 1.5f * period, name, (maxGap - minGap) / period);
+    }
+
+    const int length = SAMPLE_RATE / 20;
+    VelvetSequence sequence;
+    sequence.generate(length, 2000.f, SAMPLE_RATE, 17);
+    VelvetFir<float> fir;
+    fir.setLength(length);
+    std::vector<float> h(length);
+    for (int i = 0; i < length; ++i)
+        h[i] = fir.process(sequence, 0, i == 0 ? 1.f : 0.f);
+    double energy = 0.0;
+    int taps = 0;
+    for (float v : h) {
+        energy += v * v;
+        taps += (v != 0.f);
+    }
+    check(std::abs(taps - (int)(2000.f * length / SAMPLE_RATE)) <= 1, "velvet fir taps", std::abs(taps - (int)(2000.f * length / SAMPLE_RATE)));
+    check(std::fabs(energy - 1.0) < 1e-5, "velvet fir energy", std::fabs(energy - 1.0));
+
+    fir.clear();
+    std::vector<float> x(4 * length);
+    for (float& v : x)
+        v = rng.gaussian();
+    double err = 0.0;
+    for (int n = 0; n < (int)x.size(); ++n) {
+        double dense = 0.0;
+        for (int k = 0; k < length && k <= n; ++k)
+            dense += h[k] * x[n - k];
+        err = std::fmax(err, std::fabs(fir.process(sequence, 0, x[n]) - dense));
+    }
+    check(err < 1e-4, "velvet fir vs dense convolution", err);
+
+    // Corrélation des réponses des canaux 0 et c : ±1/sqrt(impulsions) au hasard
+    double worst = 0.0;
+    for (int c = 1; c < VelvetSequence::MAX_CHANNELS; ++c) {
+        VelvetFir<float> other;
+        other.setLength(length);
+        double corr = 0.0;
+        for (int i = 0; i < length; ++i)
+            corr += h[i] * other.process(sequence, c, i == 0 ? 1.f : 0.f);
+        worst = std::fmax(worst, std::fabs(corr));
+    }
+    check(worst < 4.0 / std::sqrt((double)sequence.delays.size()), "velvet fir channels decorrelated", worst);
+
+    VelvetFir<float_4> fir4;
+    VelvetFir<float> lane[4];
+    fir4.setLength(length);
+    double errLanes = 0.0;
+    for (int l = 0; l < 4; ++l)
+        lane[l].setLength(length);
+    for (int n = 0; n < (int)x.size(); ++n) {
+        float_4 in(x[n], -x[n], 0.5f * x[n], 1.f);
+        float_4 out = fir4.process(sequence, 4, in);
+        for (int l = 0; l < 4; ++l)
+            errLanes = std::fmax(errLanes, std::fabs(out[l] - lane[l].process(sequence, 4 + l, in[l])));
+    }
+    check(errLanes < 1e-5, "velvet fir float_4 lanes", errLanes);
+}
+
+// Compresseur : précision des tables dB, courbe statique (seuil, ratio, coude)
+// et constante de temps d'attaque
+static void checkCompressor() {
+    double errDb = 0.0, errGain = 0.0, errDb4 = 0.0, errGain4 = 0.0;
+    for (int i = 0; i < 100000; ++i) {
+        float x = 1e-4f * std::pow(1e5f, i / 99999.f); // -94 dB à +6 dB
+        double refDb = 20.0 * std::log10(x / 5.0);
+        errDb = std::fmax(errDb, std::fabs(ampToDb(x) - refDb));
+        errDb4 = std::fmax(errDb4, std::fabs(ampToDb_simd(float_4(x))[0] - refDb));
+        float db = -100.f + 130.f * i / 99999.f;
+        double refGain = std::pow(10.0, db / 20.0);
+        errGain = std::fmax(errGain, std::fabs(dbToGain(db) / refGain - 1.0));
+        errGain4 = std::fmax(errGain4, std::fabs(dbToGain_simd(float_4(db))[0] / refGain - 1.0));
+    }
+    check(errDb < 1e-3, "compressor ampToDb table (dB)", errDb);
+    check(errGain < 1e-4, "compressor dbToGain table (relative)", errGain);
+    check(errDb4 < 1e-4, "compressor ampToDb float_4 polynomial (dB)", errDb4);
+    check(errGain4 < 1e-5, "compressor dbToGain float_4 polynomial (relative)", errGain4);
+
+    CompressorSettings settings;
+    settings.threshold = -20.f;
+    settings.ratio = 4.f;
+    settings.knee = 6.f;
+    double errCurve = 0.0;
+    const float levels[] = {-40.f, -24.f, -21.f, -20.f, -18.f, -10.f, 0.f};
+    for (float level : levels) {
+        float over = level + 20.f;
+        float expected = over <= -3.f ? 0.f : over >= 3.f ? (0.25f - 1.f) * over
+            : (0.25f - 1.f) * (over + 3.f) * (over + 3.f) / 12.f;
+        errCurve = std::fmax(errCurve, std::fabs(compressorGain(settings, level) - expected));
+    }
+    check(errCurve < 1e-5, "compressor static curve (dB)", errCurve);
+
+    // Voies float_4 contre version scalaire, avec des niveaux différents par voie
+    for (int d = 0; d < DETECTOR_MODES_LEN; ++d) {
+        CompressorSettings lanes;
+        lanes.detector = d;
+        lanes.setTimes(0.002f, 0.05f, SAMPLE_RATE);
+        TestInput in(8192, 4.f, 1.f, 5);
+        CompressorState<float> scalar[4];
+        CompressorState<float_4> simd;
+        double err = 0.0;
+        for (int i = 0; i < 8192; ++i) {
+            float_4 x = float_4(0.1f, 0.5f, 1.f, 2.f) * (in.signal[i] + in.noise[i]);
+            float_4 y = simd.process(lanes, x);
+            for (int l = 0; l < 4; ++l)
+                err = std::fmax(err, std::fabs(y[l] - scalar[l].process(lanes, x[l])));
+        }
+        check(err < 1e-5, std::string("compressor float_4 lanes, ") + (d == DETECTOR_PEAK ? "peak" : "rms"), err);
+    }
+
+    // Détecteur RMS : une sinusoïde d'amplitude 5 V est à -3,01 dB
+    settings.detector = DETECTOR_RMS;
+    settings.setTimes(0.01f, 0.1f, SAMPLE_RATE);
+    CompressorState<float> rms;
+    float level = 0.f;
+    for (int i = 0; i < (int)SAMPLE_RATE; ++i)
+        level = rms.level(settings, 5.f * std::sin(2.f * (float)M_PI * 1000.f * i * SAMPLE_TIME));
+    check(std::fabs(level + 3.0103f) < 0.05f, "compressor rms level (dB)", std::fabs(level + 3.0103f));
+    settings.detector = DETECTOR_PEAK;
+
+    // Échelon de +20 dB au-dessus du seuil : la réduction atteint 63 % de sa
+    // valeur finale (-15 dB) au bout du temps d'attaque
+    settings.knee = 0.f;
+    settings.setTimes(0.01f, 0.1f, SAMPLE_RATE);
+    CompressorState<float> state;
+    float x = 5.f;
+    int steps = 0;
+    while (state.gr > -15.f * (1.f - std::exp(-1.f)) && steps < SAMPLE_RATE) {
+        state.gain(settings, x);
+        steps++;
+    }
+    double attack = steps / SAMPLE_RATE;
+    check(std::fabs(attack - 0.01) < 2e-4, "compressor attack time (s)", std::fabs(attack - 0.01));
+}
+
+// Crossover Linkwitz-Riley : la somme des bandes est un passe-tout (module 1
+// à toutes les fréquences) et chaque bande passe seule au milieu de sa plage
+static void checkCrossover() {
+    const int bandCounts[] = {3, 4};
+    for (int bands : bandCounts) {
+        CrossoverCoefs k;
+        k.set(bands, 200.f, 1000.f, 5000.f, SAMPLE_RATE);
+        CrossoverState state;
+        const int n = 1 << 14;
+        std::vector<float_4> h(n);
+        for (int i = 0; i < n; ++i)
+            h[i] = state.process(k, i == 0 ? 1.f : 0.f);
+
+        double flat = 0.0, isolation = 0.0;
+        for (int j = 0; j < 200; ++j) {
+            double freq = 20.0 * std::pow(1000.0, j / 199.0);
+            std::complex<double> sum = 0.0;
+            std::complex<double> H[4] = {};
+            for (int i = 0; i < n; ++i) {
+                std::complex<double> e = std::polar(1.0, -2.0 * M_PI * freq * i / SAMPLE_RATE);
+                for (int l = 0; l < 4; ++l)
+                    H[l] += (double)h[i][l] * e;
+            }
+            for (int l = 0; l < 4; ++l)
+                sum += H[l];
+            flat = std::fmax(flat, std::fabs(std::abs(sum) - 1.0));
+        }
+        // Milieux géométriques des bandes : l'atténuation des deux bords
+        // d'une bande de 2,3 octaves y atteint 0,7 dB
+        const float centers[] = {50.f, 450.f, 2200.f, 12000.f};
+        for (int l = 0; l < bands; ++l) {
+            double freq = centers[l];
+            if (bands == 3 && l == 2) freq = 5000.0;
+            std::complex<double> H = 0.0;
+            for (int i = 0; i < n; ++i)
+                H += (double)h[i][l] * std::polar(1.0, -2.0 * M_PI * freq * i / SAMPLE_RATE);
+            isolation = std::fmax(isolation, std::fabs(std::abs(H) - 1.0));
+        }
+        std::string name = "crossover " + std::to_string(bands) + " bands";
+        check(flat < 1e-3, name + " flat sum", flat);
+        check(isolation < 0.1, name + " passband", isolation);
+    }
+}
+
+// Réseau : sans bruit interne ni couplage, la moyenne reproduit une particule
+// seule ; le couplage resserre les unités ; la moyenne de 64 unités suit mieux
+// un signal faible que celle de 4 (résonance en réseau)
+static void checkEnsemble() {
+    const int n = 1 << 16;
+    float tau = 1.f / 300.f;
+    float h = SAMPLE_TIME / tau, g = multi_well_noise_gain(SAMPLE_TIME, tau);
+    MultiWellCoefs<float> k(2, 1.f);
+    PotentialKernel<float_4> euler = potential_kernel<float_4>(POTENTIAL_MULTI_WELL, k.N, INTEGRATOR_EULER);
+    PotentialKernel<float_4> heun = potential_kernel<float_4>(POTENTIAL_MULTI_WELL, k.N, INTEGRATOR_HEUN);
+
+    TestInput loud(n, 2.f, 2.f, 5);
+    for (int filter = FILTER_DIODE; filter <= FILTER_MULTI_WELL; ++filter) {
+        RSEnsemble ensemble;
+        float xi = -1.f;
+        double err = 0.0;
+        for (int i = 0; i < n; ++i) {
+            float y = ensemble.process(filter, heun, 16, COUPLING_NONE, 0.f, 0.f,
+                loud.signal[i], loud.noise[i], 1.f, h, g, k);
+            float ref = rsProcess_simd<float>(filter, INTEGRATOR_HEUN, xi, loud.signal[i], loud.noise[i], 1.f, h, g, k);
+            err = std::fmax(err, std::fabs(y - ref));
+        }
+        check(err < 1e-5, std::string("ensemble without noise vs single, ") + FILTER_NAMES[filter], err);
+    }
+
+    // Écart type entre unités, moyenné sur la durée
+    TestInput quiet(n, 0.15f, 0.f, 6);
+    auto spread = [&](int coupling, float strength) {
+        RSEnsemble ensemble;
+        ensemble.seed(7);
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) {
+            float mean = ensemble.process(FILTER_MULTI_WELL, euler, 64, coupling, strength, 3.f,
+                quiet.signal[i], 0.f, 1.f, h, g, k);
+            double var = 0.0;
+            for (int j = 0; j < 16; ++j)
+                for (int l = 0; l < 4; ++l)
+                    var += (ensemble.x[j][l] - mean) * (ensemble.x[j][l] - mean);
+            sum += std::sqrt(var / 64);
+        }
+        return sum / n;
+    };
+    double free = spread(COUPLING_NONE, 0.f);
+    double ring = spread(COUPLING_RING, 5.f);
+    double global = spread(COUPLING_GLOBAL, 5.f);
+    check(ring < 0.7 * free, "ensemble ring coupling reduces spread", ring / free);
+    check(global < 0.7 * free, "ensemble global coupling reduces spread", global / free);
+
+    // Rapport signal/bruit de la moyenne
+    auto snr = [&](int units) {
+        RSEnsemble ensemble;
+        ensemble.seed(8);
+        SnrMeter<float> meter;
+        meter.setTimeConstant(SAMPLE_TIME, 0.5f);
+        for (int i = 0; i < n; ++i)
+            meter.process(quiet.signal[i], ensemble.process(FILTER_MULTI_WELL, euler, units, COUPLING_NONE,
+                0.f, 3.f, quiet.signal[i], 0.f, 1.f, h, g, k));
+        return 10.0 * std::log10(meter.snr());
+    };
+    double snr4 = snr(4), snr64 = snr(64);
+    std::printf("ensemble snr: 4 units %.1f dB, 64 units %.1f dB\n", snr4, snr64);
+    check(snr64 > snr4 + 3.0, "ensemble of 64 improves snr over 4 (dB)", snr64 - snr4);
+}
+
+// Mesure de résonance : une sortie égale à l'entrée (ou à l'entrée retardée)
+// est entièrement cohérente, SPA = 1, y compris pour une entrée rapide ou
+// non sinusoïdale où la dérivée recouvre l'entrée.
+static void checkSnrMeter() {
+    const int n = 1 << 17;
+    Lcg lcg(12);
+    SnrMeter<float> white, sine;
+    white.setTimeConstant(SAMPLE_TIME, 1.f);
+    sine.setTimeConstant(SAMPLE_TIME, 1.f);
+    float prev = 0.f;
+    for (int i = 0; i < n; ++i) {
+        float u = lcg.uniform();
+        white.process(u, u);
+        float s = std::sin(2.f * (float)M_PI * 3000.f * i * SAMPLE_TIME);
+        sine.process(s, prev); // Retard d'un échantillon
+        prev = s;
+    }
+    double err = std::fmax(std::fabs(white.spa() - 1.f), std::fabs(sine.spa() - 1.f));
+    check(err < 0.02, "snr meter spa of a copy (white, delayed sine)", err);
+}
+
+// Indice du puits direct contre le puits le plus proche, et notes par défaut
+// identiques à l'ancienne liste (ré dorien depuis D4), en 1 V/oct et à
+// l'ancienne échelle
+static void checkWellNotes() {
+    int wrong = 0;
+    for (int N = 1; N <= WellNotes::MAX_WELLS; ++N) {
+        for (float Xb = 0.25f; Xb <= 4.f; Xb *= 2.f) {
+            MultiWellCoefs<float> k(N, Xb);
+            for (int i = 0; i <= 2000; ++i) {
+                float x = -5.f + i * 0.005f;
+                int nearest = 0;
+                for (int j = 1; j < N; ++j)
+                    if (std::fabs(x - (j - k.c) * k.L) < std::fabs(x - (nearest - k.c) * k.L))
+                        nearest = j;
+                if ((int)well_index_simd(x, k) != nearest)
+                    wrong++;
+            }
+        }
+    }
+    check(wrong == 0, "well index vs nearest well", wrong);
+
+    const int legacy[] = {62, 64, 65, 67, 69, 71, 72, 74, 76, 77};
+    WellNotes notes;
+    notes.set(SCALE_DORIAN, 2);
+    double err = 0.0;
+    for (int i = 0; i < 10; ++i)
+        err = std::fmax(err, std::fabs(notes.volts[i] - (legacy[i] - 60) / 12.f));
+    check(err < 1e-6, "default well notes (V/oct)", err);
+
+    notes.update(SCALE_DORIAN, 2, LEGACY_SEMITONE_VOLTS);
+    err = 0.0;
+    for (int i = 0; i < 10; ++i)
+        err = std::fmax(err, std::fabs(notes.volts[i] - 5.f * (legacy[i] - 60) / 12.f));
+    check(err < 1e-5, "legacy well notes (5/12 V per semitone)", err);
+}
+
+// Ligne à retard de la rétroaction : une rampe lue avec retard revient
+// exactement (moyenne par case et interpolation linéaire), à toute fréquence
+// d'échantillonnage, et la fréquence de Nyquist est rejetée
+static void checkDelayLine() {
+    const float rates[] = {44100.f, 48000.f, 96000.f, 192000.f};
+    const float delays[] = {0.001f, 0.0123f, 0.1f, 0.5f, 1.f};
+    for (float rate : rates) {
+        DelayLine<float> line;
+        line.setSampleRate(rate);
+        double err = 0.0;
+        int n = (int)(1.5f * rate);
+        for (int i = 0; i < n; ++i) {
+            float t = i / rate;
+            line.push(t);
+            if (t < DelayLine<float>::MAX_DELAY + 0.01f)
+                continue;
+            for (float d : delays)
+                err = std::fmax(err, std::fabs(line.read(d) - (t - d)));
+        }
+        check(err < 1e-5, "delay line at " + std::to_string((int)rate) + " Hz (s)", err);
+
+        // Signal à la fréquence de Nyquist : moyenné sur chaque case, il ne
+        // revient pas replié (au plus 1/decimation pour une décimation impaire)
+        line.reset(0.f);
+        double folded = 0.0;
+        for (int i = 0; i < n; ++i) {
+            line.push((i & 1) ? 1.f : -1.f);
+            if (i > line.decimation * 4)
+                folded = std::fmax(folded, std::fabs(line.read(0.01f)));
+        }
+        check(folded <= 1.0 / line.decimation + 1e-6, "delay line nyquist rejection at " + std::to_string((int)rate) + " Hz",
+            folded);
+        check(line.buffer.size() * 4 < 30000, "delay line size at " + std::to_string((int)rate) + " Hz (bytes)",
+            line.buffer.size() * 4.0);
+    }
+}
+
+// Histogramme à poids croissant contre oubli direct de toutes les cases (avec
+// de nombreuses remises à l'échelle), durées avant évasion et taux d'évasion
+// d'une alternance régulière entre deux puits.
+static void checkOccupancy() {
+    const int n = 20000, period = 50;
+    const float tau = 0.002f; // Remise à l'échelle toutes les ~6000 pas
+    OccupancyHistogram occupancy;
+    occupancy.setTimeConstant(SAMPLE_TIME, tau);
+    occupancy.setRange(-2.f, 2.f);
+    std::vector<double> direct(OccupancyHistogram::BINS, 0.0);
+    double decay = std::exp(-(double)SAMPLE_TIME / tau);
+    EscapeRate<float> escapes;
+    escapes.setTimeConstant(SAMPLE_TIME, 0.05f);
+    Lcg lcg(11);
+    for (int i = 0; i < n; ++i) {
+        int w = (i / period) % 2;
+        float x = (w ? 1.f : -1.f) + 0.5f * lcg.uniform();
+        occupancy.process(x, w);
+        escapes.process((float)w);
+        for (double& d : direct)
+            d *= decay;
+        direct[(int)std::floor((x + 2.f) * OccupancyHistogram::BINS / 4.f)] += 1.0;
+    }
+    occupancy.publish();
+    OccupancyHistogram::Snapshot s = occupancy.snapshot();
+    double peak = *std::max_element(direct.begin(), direct.end());
+    double errDensity = 0.0;
+    for (int b = 0; b < OccupancyHistogram::BINS; ++b)
+        errDensity = std::fmax(errDensity, std::fabs(s.density[b] - direct[b] / peak));
+    check(errDensity < 1e-5, "occupancy histogram vs direct decay", errDensity);
+
+    double expected = period * SAMPLE_TIME;
+    double errEscape = std::fmax(std::fabs(s.escapeTime[0] - expected), std::fabs(s.escapeTime[1] - expected)) / expected;
+    check(errEscape < 1e-3, "occupancy escape times", errEscape);
+    // Moyenne d'un bruit uniforme de ±0.5 sur quelques centaines d'échantillons pondérés
+    double errPosition = std::fmax(std::fabs(s.position[0] + 1.f), std::fabs(s.position[1] - 1.f));
+    check(errPosition < 0.05, "occupancy mean well positions", errPosition);
+
+    // 1 évasion toutes les period échantillons ; ondulation de la moyenne < 3 %
+    double errRate = std::fabs(escapes.rate - 1.0 / expected) * expected;
+    check(errRate < 0.03, "escape rate, regular switching", errRate);
+}
+
+// Statistiques : séjours et transitions d'une trajectoire connue, remise à zéro
+static void checkStats() {
+    RSStats stats;
+    // Canal 0 : puits 0 pendant 3 pas, puis 1 pendant 1 pas, puis 0 pendant 2 pas
+    const int wells[] = {0, 0, 0, 1, 0, 0};
+    int prev = -1;
+    for (int w : wells) {
+        stats.recordWell(prev, w, 0.5f);
+        stats.recordSamples(0.5, 0.5, 1, 0);
+        prev = w;
+        stats.publish();
+    }
+    RSStats::Snapshot s = stats.snapshot();
+    double err = std::fabs(s.transitionRate() - 2.0 / 3.0) + std::fabs(s.meanResidence(0) - 1.25)
+        + std::fabs(s.meanResidence(1) - 0.5) + std::fabs((double)s.clampHits - 6.0);
+    check(err < 1e-9 && s.transitions == 2 && s.visits[0] == 2, "stats residence and transitions", err);
+
+    stats.requestReset();
+    stats.publish();
+    s = stats.snapshot();
+    check(s.transitions == 0 && s.seconds == 0.0 && s.visits[0] == 0, "stats reset", (double)s.transitions);
+
+    // État non fini : compté avant la limite ±5 V (qui le rendrait fini), puis remis à -1
+    MultiWellCoefs<float_4> k(2, 1.f);
+    float_4 x = 0.5f, bad = 0.f;
+    float_4 noise(0.f, NAN, 0.f, INFINITY);
+    float_4 y = rsProcess_simd<float_4>(FILTER_MULTI_WELL, INTEGRATOR_HEUN, x, float_4(0.f), noise, 1.f,
+        float_4(0.01f), float_4(0.1f), k, POTENTIAL_MULTI_WELL, &bad);
+    y = rsProcess_simd<float_4>(FILTER_MULTI_WELL, INTEGRATOR_HEUN, x, float_4(0.f), float_4(0.f), 1.f,
+        float_4(0.01f), float_4(0.1f), k, POTENTIAL_MULTI_WELL, &bad);
+    double count = bad[0] + bad[1] + bad[2] + bad[3];
+    check(count == 2.0 && std::fabs(y[1] + 1.f) < 0.01f && std::fabs(y[3] + 1.f) < 0.01f && y[0] > 0.4f,
+        "stats non-finite state counted and reset", count);
+}
+
+// Anti-repliement des filtres à seuil : sinus de fréquence entière en bins,
+// puissance des harmoniques repliées (au-delà de Nyquist) rapportée à celle
+// des harmoniques directes. Un signal lent doit ressortir inchangé, au retard près.
+static void checkAntialiasing() {
+    const int n = 1 << 14;
+    const int bin = 1489; // Environ 4 kHz
+    const int harmonics = 40;
+    auto goertzel = [&](const std::vector<float>& y, int k) {
+        double w = 2.0 * M_PI * k / n, c = 2.0 * std::cos(w), s1 = 0.0, s2 = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double s0 = y[i] + c * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        return s1 * s1 + s2 * s2 - c * s1 * s2;
+    };
+    for (int filter = FILTER_DIODE; filter <= FILTER_RUBBER; ++filter) {
+        double aliasDb[ANTIALIASING_MODES_LEN];
+        for (int mode = 0; mode < ANTIALIASING_MODES_LEN; ++mode) {
+            ThresholdRunner runner(filter, mode);
+            std::vector<float> y(n);
+            for (int i = -2048; i < n; ++i) {
+                float x = 4.f * std::sin(2.0 * M_PI * bin * i / n);
+                float v = runner.process(x, 1.f)[0];
+                if (i >= 0) y[i] = v;
+            }
+            double direct = 0.0, folded = 0.0;
+            for (int h = 1; h <= harmonics; ++h) {
+                long k = (long)h * bin % n;
+                bool fold = (k > n / 2);
+                double p = goertzel(y, fold ? n - k : k);
+                // Les harmoniques au-delà de Nyquist d'origine sont hors bande pour le suréchantillonnage
+                if ((long)h * bin > n / 2) folded += p;
+                else direct += p;
+            }
+            aliasDb[mode] = 10.0 * std::log10(folded / direct);
+        }
+        std::string name = FILTER_NAMES[filter];
+        std::printf("%s aliasing (dB):", name.c_str());
+        for (int mode = 0; mode < ANTIALIASING_MODES_LEN; ++mode)
+            std::printf(" %s %.1f", ANTIALIASING_NAMES[mode], aliasDb[mode]);
+        std::printf("\n");
+        check(aliasDb[ANTIALIASING_ADAA1] < aliasDb[ANTIALIASING_NONE] - 6.0, name + " adaa1 reduces aliasing (dB)",
+            aliasDb[ANTIALIASING_NONE] - aliasDb[ANTIALIASING_ADAA1]);
+        check(aliasDb[ANTIALIASING_ADAA2] < aliasDb[ANTIALIASING_ADAA1], name + " adaa2 below adaa1 (dB)",
+            aliasDb[ANTIALIASING_ADAA1] - aliasDb[ANTIALIASING_ADAA2]);
+        check(aliasDb[ANTIALIASING_OVERSAMPLE4] < aliasDb[ANTIALIASING_OVERSAMPLE2], name + " 4x below 2x (dB)",
+            aliasDb[ANTIALIASING_OVERSAMPLE2] - aliasDb[ANTIALIASING_OVERSAMPLE4]);
+
+        // Signal lent : ADAA1 retarde d'un demi-échantillon, ADAA2 d'un échantillon
+        ThresholdRunner r1(filter, ANTIALIASING_ADAA1), r2(filter, ANTIALIASING_ADAA2);
+        double err = 0.0;
+        for (int i = 0; i < 4096; ++i) {
+            auto x = [](double t) { return (float)(4.0 * std::sin(2.0 * M_PI * 20.0 * t / SAMPLE_RATE)); };
+            float y1 = r1.process(x(i), 1.f)[0];
+            float y2 = r2.process(x(i), 1.f)[0];
+            if (i < 2) continue;
+            err = std::fmax(err, std::fabs(y1 - threshold_shape_simd<float>(filter, x(i - 0.5), 1.f)));
+            err = std::fmax(err, std::fabs(y2 - threshold_shape_simd<float>(filter, x(i - 1.0), 1.f)));
+        }
+        // Au passage du seuil, le coude est moyenné sur un pas (0,011 V ici) : écart jusqu'à pas / 8
+        check(err < 2e-3, name + " adaa on a slow signal", err);
+    }
+}
+
+// === Traces de référence ===
+
+struct Trace {
+    std::string name;
+    std::vector<float> values;
+};
+
+// Traces de 2048 échantillons, dont un sur TRACE_DECIMATION est conservé
+static const int TRACE_DECIMATION = 4;
+
+static std::vector<Trace> makeTraces() {
+    std::vector<Trace> traces;
+    const int n = 2048;
+    TestInput in(n, 1.f, 0.5f, 4);
+
+    for (int filter = FILTER_DIODE; filter <= FILTER_MULTI_WELL; ++filter) {
+        int methods = (filter == FILTER_MULTI_WELL) ? INTEGRATORS_LEN : 1;
+        for (int method = 0; method < methods; ++method) {
+            const int wellCounts[] = {1, 3, 16};
+            for (int N : wellCounts) {
+                if (filter != FILTER_MULTI_WELL && N != 1) continue;
+                Trace t;
+                t.name = std::string("rs-") + FILTER_NAMES[filter];
+                if (filter == FILTER_MULTI_WELL)
+                    t.name += std::string("-") + INTEGRATOR_NAMES[method] + "-N" + std::to_string(N);
+                MultiWellCoefs<float> k(N, 0.8f);
+                float tau = 1.f / 50.f;
+                float x = -1.f;
+                for (int i = 0; i < n; ++i) {
+                    float y = rsProcess_simd<float>(filter, method, x, in.signal[i], in.noise[i], 0.5f,
+                        SAMPLE_TIME / tau, multi_well_noise_gain(SAMPLE_TIME, tau), k);
+                    if (i % TRACE_DECIMATION == 0)
+                        t.values.push_back(y);
+                }
+                traces.push_back(t);
+            }
+        }
+    }
+
+    // Bruits à graine fixe
+    {
+        GaussianGenerator rng(1);
+        float redLast = 0.f;
+        VelvetState velvetState;
+        Trace white, red, velvet;
+        white.name = "noise-white";
+        red.name = "noise-red";
+        velvet.name = "noise-velvet";
+        for (int i = 0; i < n; ++i) {
+            float w = generateWhiteNoise(rng);
+            float r = generateRedNoise(rng, redLast);
+            float v = generateVelvetNoise(VELVET_DENSITY, SAMPLE_TIME, rng, velvetState);
+            if (i % TRACE_DECIMATION == 0) {
+                white.values.push_back(w);
+                red.values.push_back(r);
+            }
+            // Impulsions éparses : on garde tous les échantillons non nuls
+            if (v != 0.f)
+                velvet.values.push_back(float(i) * v);
+        }
+        traces.push_back(white);
+        traces.push_back(red);
+        traces.push_back(velvet);
+
+        Perlin perlin(1);
+        Trace smooth;
+        smooth.name = "noise-perlin";
+        double phase = 0.0;
+        for (int i = 0; i < n; ++i) {
+            phase = Perlin::advance(phase, 100.0 / SAMPLE_RATE);
+            if (i % TRACE_DECIMATION == 0)
+                smooth.values.push_back(perlin.sample(phase));
+        }
+        traces.push_back(smooth);
+    }
+
+    for (int d = 0; d < DETECTOR_MODES_LEN; ++d) {
+        Trace t;
+        t.name = d == DETECTOR_PEAK ? "compressor" : "compressor-rms";
+        CompressorSettings settings;
+        settings.detector = d;
+        settings.makeup = 6.f;
+        settings.setTimes(0.001f, 0.02f, SAMPLE_RATE);
+        CompressorState<float> state;
+        for (int i = 0; i < n; ++i) {
+            float y = state.process(settings, 2.f * in.signal[i] + in.noise[i]);
+            if (i % TRACE_DECIMATION == 0)
+                t.values.push_back(y);
+        }
+        traces.push_back(t);
+    }
+    return traces;
+}
+
+static bool writeTrace(const std::string& dir, const Trace& t) {
+    std::string path = dir + "/" + t.name + ".txt";
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    for (float v : t.values)
+        std::fprintf(f, "%.9g\n", v);
+    std::fclose(f);
+    return true;
+}
+
+static bool readTrace(const std::string& dir, const std::string& name, std::vector<float>& values) {
+    std::string path = dir + "/" + name + ".txt";
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return false;
+    float v;
+    while (std::fscanf(f, "%g", &v) == 1)
+        values.push_back(v);
+    std::fclose(f);
+    return true;
+}
+
+static void checkGolden(const std::string& dir) {
+    std::vector<Trace> traces = makeTraces();
+    int missing = 0;
+    for (const Trace& t : traces) {
+        std::vector<float> golden;
+        if (!readTrace(dir, t.name, golden)) {
+            missing++;
+            continue;
+        }
+        double err = (golden.size() == t.values.size()) ? 0.0 : INFINITY;
+        for (size_t i = 0; i < golden.size() && i < t.values.size(); ++i)
+            err = std::fmax(err, std::fabs(t.values[i] - golden[i]) / (1.0 + std::fabs(golden[i])));
+        check(err < 1e-4, "golden " + t.name, err);
+    }
+    if (missing > 0)
+        std::printf("%d golden trace(s) missing in %s, run `make bench-golden`\n", missing, dir.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::string goldenDir = "bench/golden";
+    std::string recordDir;
+    bool timing = true;
+    int samples = 1 << 18;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--record") && i + 1 < argc) recordDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--golden") && i + 1 < argc) goldenDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) samples = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--no-timing")) timing = false;
+        else {
+            std::fprintf(stderr, "usage: %s [--record DIR] [--golden DIR] [--samples N] [--no-timing]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!recordDir.empty()) {
+        for (const Trace& t : makeTraces()) {
+            if (!writeTrace(recordDir, t)) {
+                std::fprintf(stderr, "cannot write %s/%s.txt\n", recordDir.c_str(), t.name.c_str());
+                return 1;
+            }
+        }
+        std::printf("golden traces written to %s\n", recordDir.c_str());
+        return 0;
+    }
+
+    if (timing) {
+        benchRS(samples);
+        benchNoise(samples);
+        benchCompressor(samples);
+        benchEnsemble(samples / 16);
+        benchAntialiasing(samples / 4);
+        benchPotentials(samples / 4);
+        benchOccupancy(samples);
+    }
+
+    std::printf("\n== Checks\n");
+    checkKernels();
+    checkPotentials();
+    checkSimdLanes();
+    checkGaussian();
+    checkNoiseChannels();
+    checkColoredNoise();
+    checkVelvet();
+    checkCompressor();
+    checkCrossover();
+    checkSnrMeter();
+    checkEnsemble();
+    checkWellNotes();
+    checkDelayLine();
+    checkStats();
+    checkOccupancy();
+    checkAntialiasing();
+    checkGolden(goldenDir);
+
+    std::printf("\n%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
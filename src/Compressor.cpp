@@ -1,20 +1,49 @@
 #include "plugin.hpp"
+#include "compression.hpp"
 
+using simd::float_4;
 
 struct Compressor : Module {
+	static const int MAX_CHANNELS = 16;
 
-	float signal = 0.f;
-	float gain = 0.1f;
-	float ratio = 40.f;
-	float threshold = 0.5f;  // 
+	// Réglages lus à la cadence de contrôle
+	static const int CONTROL_DIVISION = 16;
+	dsp::ClockDivider controlDivider;
+	CompressorSettings settings;
+	int detector = DETECTOR_PEAK;
+
+	// Un détecteur par canal ; en mode lié, le plus fort niveau des canaux
+	// commande une réduction de gain commune
+	CompressorState<float_4> states[MAX_CHANNELS / 4];
+	CompressorState<float> linkedState;
+	bool linked = false;
+
+	// Multibande : les bandes d'un canal occupent les voies d'un float_4
+	int bands = 1;
+	float crossoverFreqs[3] = {};
+	float crossoverSampleRate = 0.f;
+	int crossoverBands = 0;
+	CrossoverCoefs crossover;
+	CrossoverState crossoverStates[MAX_CHANNELS], sidechainStates[MAX_CHANNELS];
+	CompressorState<float_4> bandStates[MAX_CHANNELS];
+	CompressorState<float_4> linkedBandState;
 
 	enum ParamId {
 		AMPL_PARAM,
 		RATO_PARAM,
+		THRESHOLD_PARAM,
+		KNEE_PARAM,
+		ATTACK_PARAM,
+		RELEASE_PARAM,
+		MAKEUP_PARAM,
+		XOVER_LOW_PARAM,
+		XOVER_MID_PARAM,
+		XOVER_HIGH_PARAM,
 		PARAMS_LEN
 	};
 	enum InputId {
 		INPUT,
+		SIDECHAIN_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId {
@@ -28,24 +57,163 @@ struct Compressor : Module {
 	Compressor() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
 		configParam(AMPL_PARAM, 0.f, 10.f, 0.1f, "Amplitude");
-		configParam(RATO_PARAM, 0.f, 100.f, 40.f, "Ratio");
+		configParam(RATO_PARAM, 0.f, 100.f, 40.f, "Ratio", ":1", 0.f, 0.1f);
+		configParam(THRESHOLD_PARAM, -60.f, 0.f, -20.f, "Threshold", " dB");
+		configParam(KNEE_PARAM, 0.f, 24.f, 6.f, "Knee", " dB");
+		// Temps en log2 des millisecondes
+		configParam(ATTACK_PARAM, std::log2(0.1f), std::log2(200.f), std::log2(5.f), "Attack", " ms", 2.f);
+		configParam(RELEASE_PARAM, std::log2(5.f), std::log2(2000.f), std::log2(100.f), "Release", " ms", 2.f);
+		configParam(MAKEUP_PARAM, 0.f, 24.f, 0.f, "Makeup gain", " dB");
+		// Fréquences de coupure multibande, en log2 des Hz
+		configParam(XOVER_LOW_PARAM, std::log2(40.f), std::log2(1000.f), std::log2(200.f), "Low crossover", " Hz", 2.f);
+		configParam(XOVER_MID_PARAM, std::log2(200.f), std::log2(5000.f), std::log2(1000.f), "Mid crossover", " Hz", 2.f);
+		configParam(XOVER_HIGH_PARAM, std::log2(1000.f), std::log2(16000.f), std::log2(5000.f), "High crossover (4 bands)", " Hz", 2.f);
 		configInput(INPUT, "Input");
+		configInput(SIDECHAIN_INPUT, "Sidechain");
 		configOutput(OUTPUT, "Output");
+		configBypass(INPUT, OUTPUT);
+
+		controlDivider.setDivision(CONTROL_DIVISION);
+	}
+
+	void onReset() override {
+		detector = DETECTOR_PEAK;
+		linked = false;
+		bands = 1;
+		for (int c = 0; c < MAX_CHANNELS / 4; c++)
+			states[c].reset();
+		linkedState.reset();
+		for (int c = 0; c < MAX_CHANNELS; c++) {
+			crossoverStates[c].reset();
+			sidechainStates[c].reset();
+			bandStates[c].reset();
+		}
+		linkedBandState.reset();
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "detector", json_integer(detector));
+		json_object_set_new(rootJ, "linked", json_boolean(linked));
+		json_object_set_new(rootJ, "bands", json_integer(bands));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* detectorJ = json_object_get(rootJ, "detector");
+		if (detectorJ)
+			detector = clamp((int)json_integer_value(detectorJ), 0, DETECTOR_MODES_LEN - 1);
+		json_t* linkedJ = json_object_get(rootJ, "linked");
+		if (linkedJ)
+			linked = json_boolean_value(linkedJ);
+		json_t* bandsJ = json_object_get(rootJ, "bands");
+		if (bandsJ) {
+			int b = json_integer_value(bandsJ);
+			bands = (b == 3 || b == 4) ? b : 1;
+		}
+	}
+
+	void updateSettings(float sampleRate) {
+		// Le ratio est affiché divisé par 10 : 40 donne 4:1
+		settings.ratio = std::max(params[RATO_PARAM].getValue() / 10.f, 1.f);
+		settings.threshold = params[THRESHOLD_PARAM].getValue();
+		settings.knee = params[KNEE_PARAM].getValue();
+		settings.makeup = params[MAKEUP_PARAM].getValue();
+		settings.detector = detector;
+		settings.setTimes(std::pow(2.f, params[ATTACK_PARAM].getValue()) / 1000.f,
+			std::pow(2.f, params[RELEASE_PARAM].getValue()) / 1000.f, sampleRate);
+
+		if (bands > 1) {
+			// Coupures triées, filtres recalculés seulement s'ils changent
+			float f[3] = {
+				std::pow(2.f, params[XOVER_LOW_PARAM].getValue()),
+				std::pow(2.f, params[XOVER_MID_PARAM].getValue()),
+				std::pow(2.f, params[XOVER_HIGH_PARAM].getValue()),
+			};
+			// À 3 bandes, seules les coupures basse et médiane servent
+			std::sort(f, f + bands - 1);
+			if (bands == 3)
+				f[2] = f[1];
+			if (f[0] != crossoverFreqs[0] || f[1] != crossoverFreqs[1] || f[2] != crossoverFreqs[2]
+				|| sampleRate != crossoverSampleRate || bands != crossoverBands) {
+				std::copy(f, f + 3, crossoverFreqs);
+				crossoverSampleRate = sampleRate;
+				crossoverBands = bands;
+				crossover.set(bands, f[0], f[1], f[2], sampleRate);
+			}
+		}
 	}
 
 	void process(const ProcessArgs& args) override {
-		signal = inputs[INPUT].getVoltage();
-		gain = params[AMPL_PARAM].getValue();
-		ratio = params[RATO_PARAM].getValue();
+		// Changement du nombre de bandes : filtres recalculés sans attendre
+		if (controlDivider.process() || (bands > 1 && bands != crossoverBands))
+			updateSettings(args.sampleRate);
 
-		// Simple compression algorithm
+		int channels = std::max(inputs[INPUT].getChannels(), 1);
+		float gain = params[AMPL_PARAM].getValue();
+		// Sans chaîne latérale, chaque canal se commande lui-même. Une chaîne
+		// latérale mono commande tous les canaux.
+		Input& detection = inputs[SIDECHAIN_INPUT].isConnected() ? inputs[SIDECHAIN_INPUT] : inputs[INPUT];
 
-		if(fabs(signal) > threshold) {
-			signal = threshold + (signal - threshold) / (ratio/10.f);
+		if (bands > 1) {
+			processMultiband(channels, gain);
+		}
+		else if (linked) {
+			float level = -INFINITY;
+			for (int c = 0; c < channels; c += 4) {
+				float_4 levels = states[c / 4].level(settings, detection.getPolyVoltageSimd<float_4>(c));
+				for (int l = 0; l < std::min(channels - c, 4); l++)
+					level = std::max(level, levels[l]);
+			}
+			float linkedGain = linkedState.gainFromLevel(settings, level) * gain;
+			for (int c = 0; c < channels; c += 4)
+				outputs[OUTPUT].setVoltageSimd(inputs[INPUT].getVoltageSimd<float_4>(c) * linkedGain, c);
+		}
+		else {
+			for (int c = 0; c < channels; c += 4) {
+				float_4 g = states[c / 4].gain(settings, detection.getPolyVoltageSimd<float_4>(c));
+				outputs[OUTPUT].setVoltageSimd(inputs[INPUT].getVoltageSimd<float_4>(c) * g * gain, c);
+			}
+		}
+		outputs[OUTPUT].setChannels(channels);
+	}
+
+	// Un float_4 de bandes par canal : séparation, détection et calcul de gain
+	// des bandes en parallèle, puis somme des voies
+	void processMultiband(int channels, float gain) {
+		Input& sidechain = inputs[SIDECHAIN_INPUT];
+		int sidechainChannels = sidechain.getChannels();
+		float_4 sidechainBands = 0.f;
+		if (sidechainChannels == 1)
+			sidechainBands = sidechainStates[0].process(crossover, sidechain.getVoltage(0));
+
+		float_4 x[MAX_CHANNELS], detection[MAX_CHANNELS];
+		for (int c = 0; c < channels; c++) {
+			x[c] = crossoverStates[c].process(crossover, inputs[INPUT].getVoltage(c));
+			if (sidechainChannels == 0)
+				detection[c] = x[c];
+			else if (sidechainChannels == 1)
+				detection[c] = sidechainBands;
+			else
+				detection[c] = sidechainStates[c].process(crossover, sidechain.getPolyVoltage(c));
+		}
+
+		if (linked) {
+			// Liaison bande par bande : le canal le plus fort de chaque bande
+			float_4 level = -INFINITY;
+			for (int c = 0; c < channels; c++)
+				level = simd::fmax(level, bandStates[c].level(settings, detection[c]));
+			float_4 g = linkedBandState.gainFromLevel(settings, level);
+			for (int c = 0; c < channels; c++)
+				x[c] *= g;
+		}
+		else {
+			for (int c = 0; c < channels; c++)
+				x[c] *= bandStates[c].gain(settings, detection[c]);
 		}
- 
 
-		outputs[OUTPUT].setVoltage(signal * gain);
+		for (int c = 0; c < channels; c++)
+			outputs[OUTPUT].setVoltage((x[c][0] + x[c][1] + x[c][2] + x[c][3]) * gain, c);
 	}
 };
 
@@ -63,13 +231,45 @@ struct CompressorWidget : ModuleWidget {
 		addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(25.3995, 30.4665)), module, Compressor::AMPL_PARAM));
 		addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(25.3995, 68.4665)), module, Compressor::RATO_PARAM));
 
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(8.9685, 30.4665)), module, Compressor::THRESHOLD_PARAM));
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(41.8305, 30.4665)), module, Compressor::KNEE_PARAM));
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(8.9685, 68.4665)), module, Compressor::ATTACK_PARAM));
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(41.8305, 68.4665)), module, Compressor::RELEASE_PARAM));
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(8.9685, 49.4665)), module, Compressor::MAKEUP_PARAM));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(41.8305, 49.4665)), module, Compressor::SIDECHAIN_INPUT));
+
+		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(8.9685, 90.4665)), module, Compressor::XOVER_LOW_PARAM));
+		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(25.3995, 90.4665)), module, Compressor::XOVER_MID_PARAM));
+		addParam(createParamCentered<RoundSmallBlackKnob>(mm2px(Vec(41.8305, 90.4665)), module, Compressor::XOVER_HIGH_PARAM));
+
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(8.9685, 103.9685)), module, Compressor::INPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(38.9685, 103.9685)), module, Compressor::OUTPUT));
 
 	}
 
-	
+	void appendContextMenu(Menu* menu) override {
+		Compressor* module = getModule<Compressor>();
+
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createIndexPtrSubmenuItem("Detector",
+			{"Peak", "RMS"},
+			&module->detector));
+		menu->addChild(createBoolPtrMenuItem("Link channels", "", &module->linked));
+
+		static const std::vector<int> bandCounts = {1, 3, 4};
+		menu->addChild(createIndexSubmenuItem("Bands", {"Single band", "3 bands", "4 bands"},
+			[=]() {
+				size_t i = 0;
+				while (i + 1 < bandCounts.size() && bandCounts[i] < module->bands)
+					++i;
+				return i;
+			},
+			[=](size_t i) {
+				module->bands = bandCounts[i];
+			}
+		));
+	}
 };
 
 
-Model* modelCompressor = createModel<Compressor, CompressorWidget>("Compressor");
\ No newline at end of file
+Model* modelCompressor = createModel<Compressor, CompressorWidget>("Compressor");
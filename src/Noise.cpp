@@ -1,125 +1,56 @@
 #include "plugin.hpp"
-#include <random>
-#include <vector>
-#include <cmath>
-#include <cstdint>
-
-
-// Générateur global pour le bruit blanc
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::normal_distribution<float> gauss(0.f, 1.f);
-
-// Bruit blanc gaussien
-float generateWhiteNoise(float /*sampleRate*/) {
-    return gauss(gen);
-}
-
-// Bruit rouge (Brownian)
-float generateRedNoise(float /*sampleRate*/) {
-    static float last = 0.f;
-    float white = gauss(gen) * 0.02f; // facteur pour éviter la dérive
-    last += white;
-    // Clamp pour éviter les débordements
-    if (last > 5.f) last = 5.f;
-    if (last < -5.f) last = -5.f;
-    return last;
-}
-
-// Velvet noise (distribution impulsionnelle aléatoire)
-float generateVelvetNoise(float sampleRate) {
-    static float current = 0.f;
-    static int count = 0;
-    // Densité d'impulsions (ex: 1000/s)
-    const float density = 1000.f;
-    int interval = int(sampleRate / density);
-    if (count++ >= interval) {
-        count = 0;
-        // Impulsion aléatoire +1 ou -1
-        current = (gen() % 2 == 0) ? 1.f : -1.f;
-    } else {
-        current = 0.f;
-    }
-    return current;
-}
-
-// Bruit Perlin
-
-
-class Perlin{
-public:
-    static constexpr int GRADIENT_SIZE = 65536;
-
-    Perlin() {
-        gradients.resize(GRADIENT_SIZE);
-        std::mt19937 rng(std::random_device{}());
-        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
-
-        for (int i = 0; i < GRADIENT_SIZE; ++i) {
-            gradients[i] = dist(rng);
-        }
-    }
-
-    float generateSampleAt(float time, float baseFreq, int octaves, float persistence, float lacunarity) const {
-        float x = time * baseFreq;
-        return fractalPerlin(x, octaves, persistence, lacunarity);
-    }
-
-private:
-    std::vector<float> gradients;
-
-    float fade(float t) const {
-        return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
-    }
-
-    float grad(float x) const {
-        int idx = static_cast<int>(std::floor(x)) % GRADIENT_SIZE;
-        if (idx < 0) idx += GRADIENT_SIZE;
-        return gradients[idx];
-    }
-
-    float perlin(float x) const {
-        float x0 = std::floor(x);
-        float x1 = x0 + 1.0f;
-        float t = x - x0;
-        float fade_t = fade(t);
-        float g0 = grad(x0);
-        float g1 = grad(x1);
-        float d0 = (x - x0) * g0;
-        float d1 = (x - x1) * g1;
-        return (1.0f - fade_t) * d0 + fade_t * d1;
-    }
-
-    float fractalPerlin(float x, int octaves, float persistence, float lacunarity) const {
-        float total = 0.0f;
-        float amplitude = 1.0f;
-        float frequency = 1.0f;
-        float maxAmplitude = 0.0f;
-
-        for (int i = 0; i < octaves; ++i) {
-            total += perlin(x * frequency) * amplitude;
-            maxAmplitude += amplitude;
-            amplitude *= persistence;
-            frequency *= lacunarity;
-        }
-
-        return total / maxAmplitude;
-    }
-};
+#include "bruits.hpp"
 
+using simd::float_4;
 
 
 struct Noise : Module {
-	Perlin perlinNoise = Perlin();
-	float time = 0.f;
+	static const int MAX_CHANNELS = 16;
+
+	Perlin perlinNoise;
+	double perlinPhase = 0.0; // En cellules du réseau, dans [0, Perlin::PERIOD)
+	int channels = 1;
+
+	// Constantes par échantillon, recalculées au changement de fréquence
+	// d'échantillonnage et à la cadence de contrôle
+	float sampleRate = 44100.f, sampleTime = 1.f / 44100.f;
+	double perlinStep = 0.0; // Avance de la phase Perlin par échantillon
+	float velvetDensity = VELVET_DENSITY;
+
+	// Générateur propre à l'instance, et états des bruits rouge et velvet par canal
+	GaussianGenerator rng;
+	float_4 redLast[MAX_CHANNELS / 4];
+	VelvetState velvet[MAX_CHANNELS];
+
+	// Bruit coloré 1/f^alpha, pente recalculée à la cadence de contrôle
+	static const int CONTROL_DIVISION = 16;
+	dsp::ClockDivider controlDivider;
+	ColoredNoiseFilter colorFilter;
+	ColoredNoise<float_4> colored[MAX_CHANNELS / 4];
+	float colorAlpha = -1.f, colorSampleRate = 0.f;
+
+	// Convolution velvet de l'entrée FIR : une séquence pour tous les canaux,
+	// retirée quand la densité ou la longueur changent, et une ligne à retard
+	// par groupe, allouée à la longueur choisie une fois la sortie branchée
+	static const int MAX_FIR_LENGTH_MS = 500;
+	VelvetSequence firSequence;
+	VelvetFir<float_4> velvetFir[MAX_CHANNELS / 4];
+	int firLengthMs = 100;
+	uint64_t firSeed = 0;
+	float firDensity = -1.f;
+	int firBuiltLengthMs = -1;
 
 
 	enum ParamId {
 		AMPL_PARAM,
 		PERLIN_FREQ_PARAM,
+		COLOR_PARAM,
+		VELVET_DENSITY_PARAM,
 		PARAMS_LEN
 	};
 	enum InputId {
+		COLOR_INPUT,
+		FIR_INPUT,
 		INPUTS_LEN
 	};
 	enum OutputId {
@@ -127,6 +58,8 @@ struct Noise : Module {
 		VELVET,
 		WHITE,
 		RED,
+		COLORED,
+		FIR_OUTPUT,
 		OUTPUTS_LEN
 	};
 	enum LightId {
@@ -141,48 +74,140 @@ struct Noise : Module {
 		configOutput(VELVET, "Velvet Noise");
 		configOutput(WHITE, "White Noise");
 		configOutput(RED, "Red Noise");	
+		configParam(COLOR_PARAM, 0.f, 2.f, 1.f, "Color slope")->description = "Spectral slope 1/f^alpha: 0 white, 1 pink, 2 brown";
+		configInput(COLOR_INPUT, "Color slope CV (0.2/V)");
+		configOutput(COLORED, "Colored Noise (1/f^alpha)");
+
+		configParam(VELVET_DENSITY_PARAM, std::log2(50.f), std::log2(10000.f), std::log2(VELVET_DENSITY), "Velvet density", " pulses/s", 2.f);
+		configInput(FIR_INPUT, "Velvet FIR");
+		configOutput(FIR_OUTPUT, "Velvet FIR");
+		configBypass(FIR_INPUT, FIR_OUTPUT);
+
+		controlDivider.setDivision(CONTROL_DIVISION);
+
+		onSampleRateChange();
+		resetChannels();
+	}
+
+	void onSampleRateChange() override {
+		sampleRate = APP->engine->getSampleRate();
+		sampleTime = 1.f / sampleRate;
+		updateRates();
+		firBuiltLengthMs = -1;
+	}
+
+	// Nouvelles graines, et phases des impulsions velvet tirées au hasard pour
+	// que les canaux ne pulsent pas ensemble
+	void resetChannels() {
+		rng.seed(random::u64());
+		perlinNoise.setSeed(random::u32());
+		firSeed = random::u64();
+		firBuiltLengthMs = -1;
+		for (int c = 0; c < MAX_CHANNELS / 4; c++) {
+			redLast[c] = 0.f;
+			colored[c].reset();
+			velvetFir[c].clear();
+		}
+		for (int c = 0; c < MAX_CHANNELS; c++) {
+			velvet[c] = VelvetState();
+			velvet[c].phase = rng.engine.uniform();
+		}
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "channels", json_integer(channels));
+		json_object_set_new(rootJ, "velvetFirLength", json_integer(firLengthMs));
+		return rootJ;
+	}
 
+	void dataFromJson(json_t* rootJ) override {
+		json_t* channelsJ = json_object_get(rootJ, "channels");
+		if (channelsJ)
+			channels = clamp((int)json_integer_value(channelsJ), 1, MAX_CHANNELS);
+		json_t* firLengthJ = json_object_get(rootJ, "velvetFirLength");
+		if (firLengthJ)
+			firLengthMs = clamp((int)json_integer_value(firLengthJ), 1, MAX_FIR_LENGTH_MS);
 	}
 
 
+	void updateRates() {
+		perlinStep = (double)params[PERLIN_FREQ_PARAM].getValue() * sampleTime;
+		velvetDensity = std::pow(2.f, params[VELVET_DENSITY_PARAM].getValue());
+	}
+
 	void process(const ProcessArgs& args) override {
 
 		float amplitude = params[AMPL_PARAM].getValue();
-		float perlinFreq = params[PERLIN_FREQ_PARAM].getValue();
-
-		time += args.sampleTime;
-
-		// Generate noise signals
-		float perlinNoise = generatePerlinNoise(perlinFreq, args.sampleRate) * amplitude;
-		float velvetNoise = generateVelvetNoise(args.sampleRate) * amplitude;
-		float whiteNoise = generateWhiteNoise(args.sampleRate) * amplitude;
-		float redNoise = generateRedNoise(args.sampleRate) * amplitude;
-
-        // Clamp the noise signals to avoid clipping
-        if (perlinNoise > 5.f) perlinNoise = 5.f;
-        if (perlinNoise < -5.f) perlinNoise = -5.f;
-        if (velvetNoise > 5.f) velvetNoise = 5.f;
-        if (velvetNoise < -5.f) velvetNoise = -5.f;
-        if (whiteNoise > 5.f) whiteNoise = 5.f;
-        if (whiteNoise < -5.f) whiteNoise = -5.f;
-        if (redNoise > 5.f) redNoise = 5.f;
-        if (redNoise < -5.f) redNoise = -5.f;
-
-		// Output the noise signals
-		outputs[PERLIN].setVoltage(perlinNoise);
-		outputs[VELVET].setVoltage(velvetNoise);
-		outputs[WHITE].setVoltage(whiteNoise);
-		outputs[RED].setVoltage(redNoise);
+
+		if (controlDivider.process()) {
+			updateRates();
+			updateColor(sampleRate);
+			updateVelvetFir(velvetDensity, sampleRate);
+		}
+
+		perlinPhase = Perlin::advance(perlinPhase, perlinStep);
+
+		// Generate noise signals, four channels at a time
+		for (int c = 0; c < channels; c += 4) {
+			float_4 perlinNoise = this->perlinNoise.sample_simd(perlinPhase, c) * amplitude;
+			float_4 velvetNoise = generateVelvetNoise_simd(velvetDensity, sampleTime, rng, &velvet[c]) * amplitude;
+			float_4 whiteNoise = generateWhiteNoise_simd(rng) * amplitude;
+			float_4 redNoise = generateRedNoise_simd(rng, redLast[c / 4]) * amplitude;
+			float_4 coloredNoise = colored[c / 4].process(colorFilter, rng.gaussian4()) * amplitude;
+
+			// Clamp the noise signals to avoid clipping
+			outputs[PERLIN].setVoltageSimd(simd::fmin(simd::fmax(perlinNoise, -5.f), 5.f), c);
+			outputs[VELVET].setVoltageSimd(simd::fmin(simd::fmax(velvetNoise, -5.f), 5.f), c);
+			outputs[WHITE].setVoltageSimd(simd::fmin(simd::fmax(whiteNoise, -5.f), 5.f), c);
+			outputs[RED].setVoltageSimd(simd::fmin(simd::fmax(redNoise, -5.f), 5.f), c);
+			outputs[COLORED].setVoltageSimd(simd::fmin(simd::fmax(coloredNoise, -5.f), 5.f), c);
+		}
+
+		outputs[PERLIN].setChannels(channels);
+		outputs[VELVET].setChannels(channels);
+		outputs[WHITE].setChannels(channels);
+		outputs[RED].setChannels(channels);
+		outputs[COLORED].setChannels(channels);
+
+		// Velvet FIR, polyphonique selon l'entrée
+		int firChannels = std::max(inputs[FIR_INPUT].getChannels(), 1);
+		if (outputs[FIR_OUTPUT].isConnected()) {
+			for (int c = 0; c < firChannels; c += 4)
+				outputs[FIR_OUTPUT].setVoltageSimd(velvetFir[c / 4].process(firSequence, c, inputs[FIR_INPUT].getPolyVoltageSimd<float_4>(c)), c);
+		}
+		outputs[FIR_OUTPUT].setChannels(firChannels);
+	}
+
+	// Les coefficients ne sont recalculés que si la pente ou la fréquence changent
+	void updateColor(float sampleRate) {
+		float alpha = clamp(params[COLOR_PARAM].getValue() + 0.2f * inputs[COLOR_INPUT].getVoltage(), 0.f, 2.f);
+		if (std::fabs(alpha - colorAlpha) < 1e-4f && sampleRate == colorSampleRate)
+			return;
+		colorAlpha = alpha;
+		colorSampleRate = sampleRate;
+		colorFilter.setSlope(alpha, sampleRate);
 	}
 
-	float generatePerlinNoise(float frequency, float sampleRate) {
-		float time = this->time; // Vous pouvez ajuster le temps selon vos besoins
-		return perlinNoise.generateSampleAt(time, frequency, 5, 0.5f, 2.0f);
+	// Rien n'est alloué tant que la sortie FIR n'est pas branchée, puis seules
+	// les lignes des groupes utilisés, à la longueur choisie ; elles ne sont
+	// réallouées qu'au changement de longueur, de fréquence ou de polyphonie
+	void updateVelvetFir(float density, float sampleRate) {
+		if (!outputs[FIR_OUTPUT].isConnected())
+			return;
+		if (firLengthMs != firBuiltLengthMs || std::fabs(density - firDensity) >= 1e-3f * density) {
+			firBuiltLengthMs = firLengthMs;
+			firDensity = density;
+			firSequence.generate((int)(sampleRate * firLengthMs / 1000.f), density, sampleRate, firSeed);
+		}
+		int groups = (std::max(inputs[FIR_INPUT].getChannels(), 1) + 3) / 4;
+		for (int c = 0; c < groups; c++)
+			velvetFir[c].setLength(firSequence.length);
 	}
 
 	void onReset() override {
-		time = 0.f;
-		perlinNoise = Perlin(); // Réinitialiser le générateur de bruit Perlin
+		perlinPhase = 0.0;
+		resetChannels();
 	}
 };
 
@@ -205,6 +230,47 @@ struct NoiseWidget : ModuleWidget {
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(25.4005, 68.6595)), module, Noise::VELVET));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(25.4005, 86.1215)), module, Noise::WHITE));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(25.4005, 108.3475)), module, Noise::RED));
+
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(11.1125, 68.6595)), module, Noise::COLOR_PARAM));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(11.1125, 86.1215)), module, Noise::COLOR_INPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(11.1125, 108.3475)), module, Noise::COLORED));
+
+		addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(39.6875, 68.6595)), module, Noise::VELVET_DENSITY_PARAM));
+		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(39.6875, 86.1215)), module, Noise::FIR_INPUT));
+		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(39.6875, 108.3475)), module, Noise::FIR_OUTPUT));
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		Noise* module = getModule<Noise>();
+
+		std::vector<std::string> labels;
+		for (int c = 1; c <= Noise::MAX_CHANNELS; c++)
+			labels.push_back(c == 1 ? "Mono" : string::f("%d", c));
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createIndexSubmenuItem("Polyphony channels", labels,
+			[=]() {
+				return module->channels - 1;
+			},
+			[=](size_t i) {
+				module->channels = i + 1;
+			}
+		));
+
+		static const std::vector<int> firLengths = {20, 50, 100, 200, 500};
+		std::vector<std::string> firLabels;
+		for (int ms : firLengths)
+			firLabels.push_back(string::f("%d ms", ms));
+		menu->addChild(createIndexSubmenuItem("Velvet FIR length", firLabels,
+			[=]() {
+				size_t i = 0;
+				while (i + 1 < firLengths.size() && firLengths[i] < module->firLengthMs)
+					++i;
+				return i;
+			},
+			[=](size_t i) {
+				module->firLengthMs = firLengths[i];
+			}
+		));
 	}
 };
 
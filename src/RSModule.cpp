@@ -1,9 +1,19 @@
 // RSModule.cpp
 #include "plugin.hpp"
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
-#include <iostream>
 #include "filtres.hpp"
+#include "ringbuffer.hpp"
+#include "mesures.hpp"
+#include "ensemble.hpp"
+#include "gammes.hpp"
+#include "statistiques.hpp"
+#include "occupation.hpp"
+
+using simd::float_4;
 
 // === Fonctions auxiliaires ===
 
@@ -13,45 +23,133 @@ float Mean(const std::vector<float>& buf) {
     return buf.empty() ? 0.f : sum / buf.size();
 }
 
-float Max(const std::vector<float>& buf) {
+// Point de la trajectoire affichée : entrée (signal + bruit) et sortie filtrée
+struct ScopePoint {
+    float x;
+    float y;
+};
+
+float Max(const ScopePoint* buf, size_t n, bool filtred) {
     float mx = 0.f;
-    for (float v : buf)
+    for (size_t i = 0; i < n; ++i) {
+        float v = filtred ? buf[i].y : buf[i].x;
         if (fabs(v) > fabs(mx))
             mx = v;
+    }
     return mx;
 }
 
 // === Classe principale du module ===
 
 struct RSModule : Module {
-    // États internes
+    static const int MAX_CHANNELS = 16;
+
+    // États internes (canal 0, utilisés pour l'affichage)
     float signal = 0.f, noise = 0.f, threshold = 1.f;
     float filtred_signal = 0.f;
-    float XB = 1.f, tau = 1.f / 300.f, xi = -1.f;
-    float dt = 0.01f;
+    float XB = 1.f, tau = 1.f / 300.f;
+    // Constantes par échantillon, précalculées dans onSampleRateChange()
+    float sampleRate = 44100.f;
+    float dt = 1.f / 44100.f;
+    float noiseScale = std::sqrt(dt * MULTI_WELL_REF_DT); // multi_well_noise_gain(dt, tau) * tau
     int current_filter = 0; // 1: Diode, 2: Diode2, 3: Bistable
-
-    int current_well_num = 1; // Numéro de puits 
-    float delayBuffer[44100];
-    int delayIndex = 0;
+    int channels = 1; // Nombre de canaux polyphoniques
+    int integrator = INTEGRATOR_EULER; // Schéma d'intégration du filtre multi-puits
+    int antialiasing = ANTIALIASING_NONE; // Anti-repliement des filtres à seuil
+    int potentialShape = POTENTIAL_MULTI_WELL; // Forme du potentiel du filtre multi-puits
+    // Noyaux de la forme, de N et de l'intégrateur, choisis à chaque tick de contrôle
+    PotentialKernel<float_4> stepKernel = potential_kernel<float_4>(POTENTIAL_MULTI_WELL, 1, INTEGRATOR_EULER);
+    PotentialIndex<float_4> indexKernel = potential_index_kernel<float_4>(POTENTIAL_MULTI_WELL, 1);
+
+    // États par canal, traités quatre canaux à la fois
+    float_4 xi[MAX_CHANNELS / 4];
+    ThresholdAdaa<float_4> adaa[MAX_CHANNELS / 4];
+    ThresholdOversampler<float_4> oversamplers[MAX_CHANNELS / 4];
+    OversamplingFilter oversampling;
+
+    int current_well_num[MAX_CHANNELS]; // Numéro de puits 
+
+    // Rétroaction retardée : K x(t - T) ajouté au signal du filtre multi-puits
+    DelayLine<float_4> delays[MAX_CHANNELS / 4];
+    float feedbackDelay = 0.1f; // s, à taux de contrôle
     
-    float time = 0.f;
-    float lastNoteTime = 0.2f;
-    float noteInterval = .1f; // Intervalle entre les notes
-    int closestWell = 0; // Index de la roue la plus proche
-
-    std::vector<float> wellsPosition;
-    // MIDI note list 
-    std::vector<int> midiNotes = {62, 64, 65, 67, 69, 71, 72, 74, 76, 77 };
-
-    //MIDI note -> voltage conversion
-    float midiToVolts(int note) {
-        return 5.f * (note - 60) / 12.f;
-    }
-
-    std::vector<float> buffer_y;
-    std::vector<float> buffer_x;
-    const size_t bufferSize = 512;
+    // Horloge entière en échantillons : l'ordonnancement des notes reste exact
+    // après des jours de fonctionnement
+    int64_t frame = 0;
+    int64_t lastNoteFrame[MAX_CHANNELS];
+    int64_t noteInterval = 4410; // Intervalle entre les notes, en échantillons
+    int closestWell[MAX_CHANNELS]; // Index de la roue la plus proche
+
+    // Note de chaque puits : gamme et tonique choisies dans le menu
+    int scale = SCALE_DORIAN;
+    int root = 2; // D
+    // Patchs antérieurs au 1 V/oct (sans clé "voctVersion") : 5/12 V par demi-ton
+    bool legacyPitch = false;
+    WellNotes wellNotes;
+
+    // Couche de contrôle, recalculée tous les CONTROL_DIVISION échantillons
+    static const int CONTROL_DIVISION = 16;
+    dsp::ClockDivider controlDivider;
+    bool controlsReady = false;
+    int controlGroups = 0; // Groupes de 4 canaux couverts par le dernier calcul
+    int wellNum = 1;
+
+    // Coefficients d'un groupe de 4 canaux
+    struct GroupCoefs {
+        float_4 threshold = 1.f;
+        float_4 h = 0.f; // dt / tau
+        float_4 g = 0.f; // Gain du bruit
+        MultiWellCoefs<float_4> wells;
+    };
+    // Valeurs courantes, et incréments par échantillon vers la prochaine cible :
+    // les modulations CV sont interpolées linéairement entre deux calculs
+    GroupCoefs coefs[MAX_CHANNELS / 4];
+    GroupCoefs coefsDelta[MAX_CHANNELS / 4];
+    // Seul L est interpolé ; invL et invXb2 en sont recalculés pendant la rampe,
+    // puis les puits prennent exactement la cible au dernier pas
+    int wellsRamp[MAX_CHANNELS / 4] = {}; // Pas restants
+    MultiWellCoefs<float_4> wellsTarget[MAX_CHANNELS / 4];
+
+    // Mesure de la résonance : SNR ou amplification spectrale, par canal
+    enum MeterMode {
+        METER_SNR,
+        METER_SPA,
+        METER_MODES_LEN
+    };
+    static constexpr float METER_TIME = 1.f; // Constante de temps de la mesure (s)
+    int meterMode = METER_SNR;
+    SnrMeter<float_4> meters[MAX_CHANNELS / 4];
+    float meterDb = 0.f; // Canal 0, pour l'affichage
+
+    // Mode réseau : chaque canal est la moyenne de ensembleUnits unités (0 : une particule)
+    int ensembleUnits = 0;
+    int ensembleCoupling = COUPLING_NONE;
+    RSEnsemble ensembles[MAX_CHANNELS];
+
+    // Statistiques d'exécution, publiées à la cadence de contrôle. Le coût
+    // d'un échantillon est mesuré un appel sur STATS_TIMING_INTERVAL ; premier
+    // avec CONTROL_DIVISION pour couvrir toutes les phases du calcul de contrôle.
+    static const int STATS_TIMING_INTERVAL = 1021;
+    RSStats stats;
+    int statsCountdown = 0;
+    int statsFrames = 0; // Échantillons depuis la dernière publication
+    int statsWell[MAX_CHANNELS];  // Puits courant de chaque canal (-1 : aucun)
+    int statsDwell[MAX_CHANNELS]; // Échantillons passés dans ce puits et pas encore crédités
+    float_4 statsClamp[MAX_CHANNELS / 4];
+    float_4 statsNonFinite[MAX_CHANNELS / 4];
+
+    // Occupation et évasions du filtre multi-puits : taux d'évasion par canal
+    // (sortie ESCAPE), histogramme de position du canal 0 pour l'affichage
+    static constexpr float ESCAPE_TIME = 2.f; // Constante de temps de l'oubli (s)
+    static const int OCCUPANCY_PUBLISH_DIVISION = 1024;
+    EscapeRate<float_4> escapes[MAX_CHANNELS / 4];
+    OccupancyHistogram occupancy;
+    dsp::ClockDivider occupancyDivider;
+
+    // Trajectoire pour l'affichage, écrite par le thread audio
+    static const size_t SCOPE_CAPACITY = 8192;
+    RingBuffer<ScopePoint> scope{SCOPE_CAPACITY};
+    int scopeLength = 512; // Nombre d'échantillons affichés
 
     // Paramètres du module
     enum ParamId {
@@ -69,6 +167,11 @@ struct RSModule : Module {
         SWITCH_DIODE1,
         SWITCH_DIODE2,
         MODE_PARAM,
+        ENSEMBLE_COUPLING_PARAM, // Réglés depuis le menu
+        ENSEMBLE_NOISE_PARAM,
+        DELAY_PARAM,
+        FEEDBACK_PARAM,
+        POTENTIAL_ASYMMETRY_PARAM, // Réglé depuis le menu
         PARAMS_LEN
     };
 
@@ -86,6 +189,8 @@ struct RSModule : Module {
         OUTPUT,
         GATE_OUTPUT,
         VOCT_OUTPUT,
+        SNR_OUTPUT,
+        ESCAPE_OUTPUT,
         OUTPUTS_LEN
     };
 
@@ -115,16 +220,73 @@ struct RSModule : Module {
         configParam(SWITCH_DIODE1, 0.f, 1.f, 0.f, "Diode 1 Switch");
         configParam(SWITCH_DIODE2, 0.f, 1.f, 0.f, "Diode 2 Switch");
         configParam(MODE_PARAM, 0.f, 1.f, 0.f, "Mode Switch (Normal/Rate) Mode");
+        configParam(ENSEMBLE_COUPLING_PARAM, 0.f, 10.f, 1.f, "Ensemble coupling strength");
+        configParam(ENSEMBLE_NOISE_PARAM, 0.f, 10.f, 2.f, "Ensemble internal noise", " V");
+        configParam(DELAY_PARAM, -3.f, 0.f, -1.f, "Feedback delay", " ms", 10.f, 1000.f);
+        configParam(FEEDBACK_PARAM, -2.f, 2.f, 0.f, "Delayed feedback gain")->description =
+            "Delayed copy of the multi-well state added to the signal term (0: off)";
+        configParam(POTENTIAL_ASYMMETRY_PARAM, -0.9f, 0.9f, 0.5f, "Bistable asymmetry")->description =
+            "Right well at Xb (1 + a), left well at -Xb (1 - a)";
 
         configOutput(GATE_OUTPUT, "Gate Output");
         configOutput(VOCT_OUTPUT, "V/oct Output");
         configOutput(OUTPUT, "Filtered Output");
+        configOutput(SNR_OUTPUT, "SNR / spectral power amplification (1 V per 10 dB)");
+        configOutput(ESCAPE_OUTPUT, "Mean escape rate (1 V per decade, 0 V = 1 escape/s)");
 
         configInput(STATIC_MOD_INPUT, "Static Modulation Input");
         configInput(INPUT_NOISE, "Noise Input");
         configInput(INPUT_SIGNAL, "Signal Input");
         configInput(INPUT_GATE, "Gate Modulation Input");
 
+        controlDivider.setDivision(CONTROL_DIVISION);
+        occupancyDivider.setDivision(OCCUPANCY_PUBLISH_DIVISION);
+        oversampling.setFactor(2);
+        for (int c = 0; c < MAX_CHANNELS; ++c)
+            ensembles[c].seed(random::u64());
+        onSampleRateChange();
+        resetChannels();
+    }
+
+    // Constantes par échantillon, et lignes à retard dimensionnées pour le retard maximal
+    void onSampleRateChange() override {
+        sampleRate = APP->engine->getSampleRate();
+        dt = 1.f / sampleRate;
+        noiseScale = std::sqrt(dt * MULTI_WELL_REF_DT);
+        for (int g = 0; g < MAX_CHANNELS / 4; ++g) {
+            meters[g].setTimeConstant(dt, METER_TIME);
+            escapes[g].setTimeConstant(dt, ESCAPE_TIME);
+            delays[g].setSampleRate(sampleRate);
+        }
+        occupancy.setTimeConstant(dt, ESCAPE_TIME);
+        resetDelays();
+        controlsReady = false; // h et g recalculés sans interpolation
+    }
+
+    void resetDelays() {
+        for (int g = 0; g < MAX_CHANNELS / 4; ++g)
+            delays[g].reset(-1.f);
+    }
+
+    void resetChannels() {
+        for (int g = 0; g < MAX_CHANNELS / 4; ++g) {
+            xi[g] = -1.f;
+            adaa[g].reset();
+            oversamplers[g].reset();
+            statsClamp[g] = 0.f;
+            statsNonFinite[g] = 0.f;
+            escapes[g].reset();
+        }
+        occupancy.reset();
+        resetDelays();
+        for (int c = 0; c < MAX_CHANNELS; ++c) {
+            current_well_num[c] = 1;
+            lastNoteFrame[c] = (int64_t)(0.2f * sampleRate);
+            closestWell[c] = 0;
+            ensembles[c].reset(-1.f);
+            statsWell[c] = -1;
+            statsDwell[c] = 0;
+        }
     }
 
     void onReset() override {
@@ -133,14 +295,60 @@ struct RSModule : Module {
         filtred_signal = 0.f;
         XB = 1.f;
         tau = 1.f / 300.f;
-        xi = -1.f;
-        buffer_y.clear();
-        buffer_x.clear();
-        time = 0.f;
-        lastNoteTime = 0.2f;
-       
-        setwellsPositions();
+        scope.clear();
+        frame = 0;
+        controlsReady = false;
+        for (int g = 0; g < MAX_CHANNELS / 4; ++g)
+            meters[g].reset();
+        meterDb = 0.f;
+        resetChannels();
+    }
 
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "integrator", json_integer(integrator));
+        json_object_set_new(rootJ, "antialiasing", json_integer(antialiasing));
+        json_object_set_new(rootJ, "potentialShape", json_integer(potentialShape));
+        json_object_set_new(rootJ, "scopeLength", json_integer(scopeLength));
+        json_object_set_new(rootJ, "meterMode", json_integer(meterMode));
+        json_object_set_new(rootJ, "ensembleUnits", json_integer(ensembleUnits));
+        json_object_set_new(rootJ, "ensembleCoupling", json_integer(ensembleCoupling));
+        json_object_set_new(rootJ, "scale", json_integer(scale));
+        json_object_set_new(rootJ, "root", json_integer(root));
+        json_object_set_new(rootJ, "voctVersion", json_integer(legacyPitch ? 0 : 1));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* integratorJ = json_object_get(rootJ, "integrator");
+        if (integratorJ)
+            integrator = clamp((int)json_integer_value(integratorJ), 0, INTEGRATORS_LEN - 1);
+        json_t* antialiasingJ = json_object_get(rootJ, "antialiasing");
+        if (antialiasingJ)
+            antialiasing = clamp((int)json_integer_value(antialiasingJ), 0, ANTIALIASING_MODES_LEN - 1);
+        json_t* potentialShapeJ = json_object_get(rootJ, "potentialShape");
+        if (potentialShapeJ)
+            potentialShape = clamp((int)json_integer_value(potentialShapeJ), 0, POTENTIAL_SHAPES_LEN - 1);
+        json_t* scopeLengthJ = json_object_get(rootJ, "scopeLength");
+        if (scopeLengthJ)
+            scopeLength = clamp((int)json_integer_value(scopeLengthJ), 1, (int)SCOPE_CAPACITY);
+        json_t* meterModeJ = json_object_get(rootJ, "meterMode");
+        if (meterModeJ)
+            meterMode = clamp((int)json_integer_value(meterModeJ), 0, METER_MODES_LEN - 1);
+        json_t* ensembleUnitsJ = json_object_get(rootJ, "ensembleUnits");
+        if (ensembleUnitsJ)
+            ensembleUnits = clamp((int)json_integer_value(ensembleUnitsJ), 0, RSEnsemble::MAX_UNITS) / 4 * 4;
+        json_t* ensembleCouplingJ = json_object_get(rootJ, "ensembleCoupling");
+        if (ensembleCouplingJ)
+            ensembleCoupling = clamp((int)json_integer_value(ensembleCouplingJ), 0, COUPLINGS_LEN - 1);
+        json_t* scaleJ = json_object_get(rootJ, "scale");
+        if (scaleJ)
+            scale = clamp((int)json_integer_value(scaleJ), 0, SCALES_LEN - 1);
+        json_t* voctVersionJ = json_object_get(rootJ, "voctVersion");
+        legacyPitch = !voctVersionJ || json_integer_value(voctVersionJ) < 1;
+        json_t* rootNoteJ = json_object_get(rootJ, "root");
+        if (rootNoteJ)
+            root = clamp((int)json_integer_value(rootNoteJ), 0, 11);
     }
 
     void updateSwitches() {
@@ -156,152 +364,360 @@ struct RSModule : Module {
             current_filter = 2;
         }
     }
-    // Fonction de filtrage
-    float getFilteredSignal() {
-        int N = (int)params[DYNAMIC_well_NUM].getValue();
-        float XB = params[DYNAMIC_well_POS].getValue();
-        float threshold = params[STATIC_THRESHOLD].getValue();
-        float signal = inputs[INPUT_SIGNAL].getVoltage();
-        float noise = inputs[INPUT_NOISE].getVoltage();
-        float tau = 1.f / params[DYNAMIC_SYSTEM_TIME].getValue();
-
-        if (inputs[STATIC_MOD_INPUT].isConnected()) {
-            float static_mod = inputs[STATIC_MOD_INPUT].getVoltage();
-            static_mod = fabs(static_mod) >= 1.f ? 1.f : static_mod;
-            threshold += static_mod * params[STATIC_MOD_PARAM].getValue();
+    // Calcul à taux de contrôle : topologie, seuils, tau et modulations
+    void updateControls() {
+        int previousFilter = current_filter;
+        updateSwitches();
+        // Retour au multi-puits : la ligne repart de l'état courant
+        if (current_filter == FILTER_MULTI_WELL && previousFilter != FILTER_MULTI_WELL) {
+            for (int g = 0; g < MAX_CHANNELS / 4; ++g)
+                delays[g].reset(xi[g]);
         }
-        if (inputs[DYNAMIC_well_POS_MOD_INPUT].isConnected()) {
-            float dynamic_mod = inputs[DYNAMIC_well_POS_MOD_INPUT].getVoltage();
-            dynamic_mod = fabs(dynamic_mod) >= 1.f ? 1.f : dynamic_mod;
-            XB += dynamic_mod * params[DYNAMIC_well_POS_MOD_PARAM].getValue();
+        noteInterval = std::llround(params[NOTE_RATE].getValue() * sampleRate);
+        feedbackDelay = std::pow(10.f, params[DELAY_PARAM].getValue());
+        int factor = (antialiasing == ANTIALIASING_OVERSAMPLE4) ? 4 : 2;
+        if (antialiasing >= ANTIALIASING_OVERSAMPLE2 && oversampling.factor != factor) {
+            oversampling.setFactor(factor);
+            for (int g = 0; g < MAX_CHANNELS / 4; ++g)
+                oversamplers[g].reset();
         }
-        if (inputs[DYNAMIC_SYSTEM_TIME_MOD_INPUT].isConnected()) {
-            float dynamic_mod = inputs[DYNAMIC_SYSTEM_TIME_MOD_INPUT].getVoltage();
-            dynamic_mod = fabs(dynamic_mod) >= 1.f ? 1.f : dynamic_mod;
-            tau += dynamic_mod * params[DYNAMIC_SYSTEM_TIME_MOD_PARAM].getValue();
-            
+
+        int N = (int)params[DYNAMIC_well_NUM].getValue();
+        if (N < 1) N = 1;
+        float XB_param = params[DYNAMIC_well_POS].getValue();
+        float asymmetry = params[POTENTIAL_ASYMMETRY_PARAM].getValue();
+        bool topologyChanged = (N != wellNum);
+        wellNum = N;
+        stepKernel = potential_kernel<float_4>(potentialShape, N, integrator);
+        indexKernel = potential_index_kernel<float_4>(potentialShape, N);
+        wellNotes.update(scale, root, legacyPitch ? LEGACY_SEMITONE_VOLTS : SEMITONE_VOLTS);
+        // Mêmes bornes que la courbe affichée
+        float occupancyRange = 2.f * potential_wells(potentialShape, N) * XB_param + 5.f;
+        occupancy.setRange(-occupancyRange, occupancyRange);
+
+        float threshold_param = params[STATIC_THRESHOLD].getValue();
+        float tau_param = 1.f / params[DYNAMIC_SYSTEM_TIME].getValue();
+        int groups = (channels + 3) / 4;
+
+        for (int c = 0; c < channels; c += 4) {
+            float_4 XB = XB_param;
+            float_4 threshold = threshold_param;
+            float_4 tau = tau_param;
+
+            if (inputs[STATIC_MOD_INPUT].isConnected()) {
+                float_4 static_mod = inputs[STATIC_MOD_INPUT].getPolyVoltageSimd<float_4>(c);
+                static_mod = simd::ifelse(simd::fabs(static_mod) >= 1.f, 1.f, static_mod);
+                threshold += static_mod * params[STATIC_MOD_PARAM].getValue();
+            }
+            if (inputs[DYNAMIC_well_POS_MOD_INPUT].isConnected()) {
+                float_4 dynamic_mod = inputs[DYNAMIC_well_POS_MOD_INPUT].getPolyVoltageSimd<float_4>(c);
+                dynamic_mod = simd::ifelse(simd::fabs(dynamic_mod) >= 1.f, 1.f, dynamic_mod);
+                XB += dynamic_mod * params[DYNAMIC_well_POS_MOD_PARAM].getValue();
+            }
+            if (inputs[DYNAMIC_SYSTEM_TIME_MOD_INPUT].isConnected()) {
+                float_4 dynamic_mod = inputs[DYNAMIC_SYSTEM_TIME_MOD_INPUT].getPolyVoltageSimd<float_4>(c);
+                dynamic_mod = simd::ifelse(simd::fabs(dynamic_mod) >= 1.f, 1.f, dynamic_mod);
+                tau += dynamic_mod * params[DYNAMIC_SYSTEM_TIME_MOD_PARAM].getValue();
+            }
+
+            GroupCoefs target;
+            target.threshold = threshold;
+            target.h = dt / tau;
+            target.g = noiseScale / tau;
+            target.wells.set(N, XB);
+            target.wells.setAsymmetry(asymmetry);
+
+            GroupCoefs& k = coefs[c / 4];
+            GroupCoefs& d = coefsDelta[c / 4];
+            if (!controlsReady || topologyChanged || c / 4 >= controlGroups) {
+                // Pas d'interpolation au démarrage ou quand N change
+                k = target;
+                d.threshold = d.h = d.g = 0.f;
+                d.wells.L = 0.f;
+                wellsRamp[c / 4] = 0;
+            } else {
+                const float r = 1.f / CONTROL_DIVISION;
+                d.threshold = (target.threshold - k.threshold) * r;
+                d.h = (target.h - k.h) * r;
+                d.g = (target.g - k.g) * r;
+                d.wells.L = (target.wells.L - k.wells.L) * r;
+                bool moving = false;
+                for (int l = 0; l < 4; ++l)
+                    moving |= (target.wells.L[l] != k.wells.L[l]);
+                wellsRamp[c / 4] = moving ? CONTROL_DIVISION : 0;
+                wellsTarget[c / 4] = target.wells;
+                // Facteurs d'asymétrie réglés au menu : pris directement
+                k.wells.asymNeg = target.wells.asymNeg;
+                k.wells.asymPos = target.wells.asymPos;
+            }
         }
+        controlGroups = groups;
+        controlsReady = true;
+    }
 
-        float dt = this->dt;
-        float filtred_signal = 0.f;
-        float xi = this->xi; // État interne du filtre
+    // Sortie de mesure, en dB, à taux de contrôle
+    void updateMeters() {
+        for (int c = 0; c < channels; c += 4) {
+            const SnrMeter<float_4>& m = meters[c / 4];
+            float_4 ratio = (meterMode == METER_SPA) ? m.spa() : m.snr();
+            float_4 db = (10.f / std::log(10.f)) * simd::log(simd::fmax(ratio, 1e-10f));
+            outputs[SNR_OUTPUT].setVoltageSimd(simd::fmin(simd::fmax(db / 10.f, -10.f), 10.f), c);
+            if (c == 0)
+                meterDb = db[0];
+            // Pas d'évasion (ou autre filtre) : -5 V
+            float_4 rate = simd::fmax(escapes[c / 4].rate, 1e-5f);
+            outputs[ESCAPE_OUTPUT].setVoltageSimd(simd::fmin(simd::log(rate) * (1.f / std::log(10.f)), 5.f), c);
+        }
+        outputs[SNR_OUTPUT].setChannels(channels);
+        outputs[ESCAPE_OUTPUT].setChannels(channels);
+    }
 
-        // Vérification des valeurs
-        //std::cout<< "dt: "<< dt << std::endl;
+    // Avance d'un échantillon vers la cible de contrôle
+    void advanceCoefs(int g) {
+        GroupCoefs& k = coefs[g];
+        const GroupCoefs& d = coefsDelta[g];
+        k.threshold += d.threshold;
+        k.h += d.h;
+        k.g += d.g;
+        if (wellsRamp[g] > 0) {
+            if (--wellsRamp[g] == 0) {
+                k.wells.L = wellsTarget[g].L;
+                k.wells.invL = wellsTarget[g].invL;
+                k.wells.invXb2 = wellsTarget[g].invXb2;
+            } else {
+                // Réciproques tenues cohérentes avec L (Xb = L / 2)
+                k.wells.L += d.wells.L;
+                k.wells.invL = 1.f / k.wells.L;
+                k.wells.invXb2 = 4.f * k.wells.invL * k.wells.invL;
+            }
+        }
+    }
 
-        if (N < 1) N = 1;
+    // Fonction de filtrage (canaux c à c + 3), uniquement sur coefficients précalculés
+    float_4 getFilteredSignal(int c, float_4 signal, float_4 noise) {
+        const GroupCoefs& k = coefs[c / 4];
+        if (antialiasing != ANTIALIASING_NONE && (current_filter == FILTER_DIODE || current_filter == FILTER_RUBBER)) {
+            float_4 x = signal + noise;
+            float_4 y;
+            if (antialiasing == ANTIALIASING_ADAA1)
+                y = adaa[c / 4].process1(current_filter, x, k.threshold);
+            else if (antialiasing == ANTIALIASING_ADAA2)
+                y = adaa[c / 4].process2(current_filter, x, k.threshold);
+            else
+                y = oversamplers[c / 4].process(oversampling, current_filter, x, k.threshold);
+            // Valeur non finie : comptée avant la limite, états du groupe effacés
+            float_4 finite = simd::fabs(y) < INFINITY;
+            statsNonFinite[c / 4] += simd::ifelse(finite, 0.f, 1.f);
+            if (simd::movemask(finite) != 0xf) {
+                adaa[c / 4].reset();
+                oversamplers[c / 4].reset();
+                y = simd::ifelse(finite, y, 0.f);
+            }
+            return simd::fmin(simd::fmax(y, -5.f), 5.f);
+        }
+        return rsProcess_simd(current_filter, stepKernel, xi[c / 4], signal, noise, k.threshold, k.h, k.g, k.wells,
+            &statsNonFinite[c / 4]);
+    }
 
-        if (current_filter == 0) {
-            filtred_signal = 0.f; // Pas de filtrage
-        } else if (current_filter == 1) {
-            filtred_signal = diode(signal + noise, threshold);
-        } else if (current_filter == 2) {
-            filtred_signal = rubber(signal + noise, threshold);
-        } else if (current_filter == 3) {
-            filtred_signal = multiWellFilter(xi, signal, noise, dt, tau, N, XB);
-            xi = filtred_signal; // mise à jour de l'état interne
+    // Coefficients des puits du canal c
+    MultiWellCoefs<float> channelWells(int c) {
+        const MultiWellCoefs<float_4>& w = coefs[c / 4].wells;
+        MultiWellCoefs<float> k;
+        k.N = w.N;
+        k.c = w.c;
+        k.L = w.L[c % 4];
+        k.invL = w.invL[c % 4];
+        k.invXb2 = w.invXb2[c % 4];
+        k.asymNeg = w.asymNeg[c % 4];
+        k.asymPos = w.asymPos[c % 4];
+        return k;
+    }
+
+    // Mode réseau (canaux c à c + 3) : un réseau d'unités par canal, coefficients du canal
+    float_4 getEnsembleSignal(int c, float_4 signal, float_4 noise) {
+        const GroupCoefs& k = coefs[c / 4];
+        float strength = params[ENSEMBLE_COUPLING_PARAM].getValue();
+        float sigma = params[ENSEMBLE_NOISE_PARAM].getValue();
+        float_4 out = 0.f;
+        for (int l = 0; l < 4 && c + l < channels; ++l) {
+            out[l] = ensembles[c + l].process(current_filter, stepKernel, ensembleUnits, ensembleCoupling,
+                strength, sigma, signal[l], noise[l], k.threshold[l], k.h[l], k.g[l], channelWells(c + l));
         }
-        return filtred_signal;
+        return out;
     }
 
-    // wells positions 
-    void setwellsPositions() {
-        int N = (int)params[DYNAMIC_well_NUM].getValue();
-        float XB = params[DYNAMIC_well_POS].getValue();
-        float L = 2.0f * XB;
-        wellsPosition.resize(N+1);
-
-        std::vector<float> x0_list(N);
-        for (int i = 0; i < N; ++i)
-            wellsPosition[i] = (i - (N - 1) / 2.0f) * L;
-       
+    // Puits contenant y (canal c), calculé directement depuis la position
+    int getCurrentWell(int c, float y) {
+        return (int)potential_index_simd(potentialShape, y, channelWells(c));
     }
-    // well number
-    int getCurrentwellNum(float v) {
-        float XB = params[DYNAMIC_well_POS].getValue();
-        float min_diff = std::numeric_limits<float>::max();
-
-        for (int i = 0; i < (int)wellsPosition.size(); ++i) {
-            float diff = fabs(wellsPosition[i] - v);
-            if (diff <= XB && diff < min_diff) {
-                min_diff = diff;
-                return i;
+
+    // Puits des canaux c à c + 3 à cet échantillon, comme pour le taux
+    // d'évasion : chaque changement compte, le séjour quitté est crédité
+    void countWells(int c, float_4 w) {
+        int lanes = std::min(channels - c, 4);
+        for (int l = 0; l < lanes; ++l) {
+            int wl = (int)w[l];
+            int& prev = statsWell[c + l];
+            if (wl != prev) {
+                if (prev >= 0)
+                    stats.recordStay(prev, statsDwell[c + l] * (double)dt);
+                stats.recordEntry(prev, wl);
+                prev = wl;
+                statsDwell[c + l] = 0;
             }
+            statsDwell[c + l]++;
+        }
+    }
+
+    // Publication des statistiques accumulées depuis le dernier appel
+    void updateStats() {
+        float elapsed = statsFrames * dt;
+        statsFrames = 0;
+        uint64_t clamps = 0, nonFinite = 0;
+        for (int c = 0; c < channels; ++c) {
+            clamps += (uint64_t)statsClamp[c / 4][c % 4];
+            nonFinite += (uint64_t)statsNonFinite[c / 4][c % 4];
+            nonFinite += ensembles[c].takeNonFinite();
+        }
+        for (int g = 0; g < MAX_CHANNELS / 4; ++g) {
+            statsClamp[g] = 0.f;
+            statsNonFinite[g] = 0.f;
+        }
+        // Séjours en cours crédités jusqu'ici ; les canaux qui ne suivent plus
+        // de puits repartent de zéro
+        for (int c = 0; c < MAX_CHANNELS; ++c) {
+            if (statsWell[c] >= 0)
+                stats.recordStay(statsWell[c], statsDwell[c] * (double)dt);
+            statsDwell[c] = 0;
+            if (c >= channels || current_filter != FILTER_MULTI_WELL)
+                statsWell[c] = -1;
+        }
+        stats.recordSamples(elapsed, (double)elapsed * channels, clamps, nonFinite);
+        stats.publish();
+    }
+
+    // Statistiques publiées, pour l'export (thread UI)
+    json_t* statsToJson() {
+        RSStats::Snapshot s = stats.snapshot();
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "seconds", json_real(s.seconds));
+        json_object_set_new(rootJ, "nsPerSample", json_real(s.nsPerSample));
+        json_object_set_new(rootJ, "transitions", json_integer(s.transitions));
+        json_object_set_new(rootJ, "transitionsPerSecond", json_real(s.transitionRate()));
+        json_object_set_new(rootJ, "clampHits", json_integer(s.clampHits));
+        json_object_set_new(rootJ, "nonFinite", json_integer(s.nonFinite));
+        json_t* wellsJ = json_array();
+        for (int w = 0; w < RSStats::MAX_WELLS; ++w) {
+            if (!s.visits[w])
+                continue;
+            json_t* wellJ = json_object();
+            json_object_set_new(wellJ, "well", json_integer(w));
+            json_object_set_new(wellJ, "visits", json_integer(s.visits[w]));
+            json_object_set_new(wellJ, "residence", json_real(s.residence[w]));
+            json_object_set_new(wellJ, "meanResidence", json_real(s.meanResidence(w)));
+            json_array_append_new(wellsJ, wellJ);
         }
-        return 0;
+        json_object_set_new(rootJ, "wells", wellsJ);
+        return rootJ;
     }
-       
 
     void process(const ProcessArgs& args) override {
-        // Lecture des entrées
+        bool timed = (++statsCountdown >= STATS_TIMING_INTERVAL);
+        std::chrono::steady_clock::time_point start;
+        if (timed) {
+            statsCountdown = 0;
+            start = std::chrono::steady_clock::now();
+        }
+
+        // Lecture des entrées (canal 0 pour l'affichage)
         signal = inputs[INPUT_SIGNAL].getVoltage();
         noise = inputs[INPUT_NOISE].getVoltage();
+        channels = std::max(std::max(inputs[INPUT_SIGNAL].getChannels(), inputs[INPUT_NOISE].getChannels()), 1);
+
+        ++frame;
+        ++statsFrames;
+
+        bool controlTick = !controlsReady || (channels + 3) / 4 > controlGroups || controlDivider.process();
+        if (controlTick)
+            updateControls();
+
+        float feedback = params[FEEDBACK_PARAM].getValue();
+        bool delayed = (feedback != 0.f && current_filter == FILTER_MULTI_WELL);
+
+        for (int c = 0; c < channels; c += 4) {
+            advanceCoefs(c / 4);
+            float_4 in_signal = inputs[INPUT_SIGNAL].getPolyVoltageSimd<float_4>(c);
+            float_4 in_noise = inputs[INPUT_NOISE].getPolyVoltageSimd<float_4>(c);
+            float_4 drive = in_signal;
+            if (delayed)
+                drive += feedback * delays[c / 4].read(feedbackDelay);
+            float_4 out = (ensembleUnits > 0) ? getEnsembleSignal(c, drive, in_noise)
+                                              : getFilteredSignal(c, drive, in_noise);
+            if (current_filter == FILTER_MULTI_WELL) {
+                delays[c / 4].push(out);
+                float_4 w = indexKernel(out, coefs[c / 4].wells);
+                escapes[c / 4].process(w);
+                countWells(c, w);
+                if (c == 0)
+                    occupancy.process(out[0], (int)w[0]);
+            } else {
+                escapes[c / 4].reset();
+            }
+            meters[c / 4].process(in_signal, out);
+            statsClamp[c / 4] += simd::ifelse(simd::fabs(out) >= 5.f, 1.f, 0.f);
+            outputs[OUTPUT].setVoltageSimd(out, c);
+        }
+        outputs[OUTPUT].setChannels(channels);
+        if (occupancyDivider.process())
+            occupancy.publish();
+        if (controlTick) {
+            updateMeters();
+            updateStats();
+        }
+        filtred_signal = outputs[OUTPUT].getVoltage(0);
 
-        noteInterval = params[NOTE_RATE].getValue();
-        dt = args.sampleTime;
-
-        time += dt; // Mise à jour du temps écoulé
+        for (int c = 0; c < channels; ++c) {
+            float y = outputs[OUTPUT].getVoltage(c);
 
-     
-        float v_oct = 0.f;
-        updateSwitches();
-        setwellsPositions();
+            if (current_filter == 3) {
 
-        filtred_signal = getFilteredSignal();
+                if (frame - lastNoteFrame[c] >= noteInterval) {
+                    current_well_num[c] = getCurrentWell(c, y);
+                    if (current_well_num[c] == closestWell[c]) {
+                        outputs[GATE_OUTPUT].setVoltage(10.f, c);
+                    } else {
+                        outputs[GATE_OUTPUT].setVoltage(0.f, c);
+                        closestWell[c] = current_well_num[c];
+                    }
 
-        
-        if(filtred_signal > 5.f) {
-            filtred_signal = 5.f; // Limite supérieure
-        } else if (filtred_signal < -5.f) {
-            filtred_signal = -5.f; // Limite inférieure
-        }
-        
-        if(current_filter == 3){
+                    lastNoteFrame[c] = frame;
 
-            if((time - lastNoteTime) >= noteInterval){
-                current_well_num = getCurrentwellNum(filtred_signal);
-                if(current_well_num == closestWell) {
-                    outputs[GATE_OUTPUT].setVoltage(10.f);
                 } else {
-                    outputs[GATE_OUTPUT].setVoltage(0.f);
-                    closestWell = current_well_num;
+                    outputs[GATE_OUTPUT].setVoltage(10.f, c);
                 }
-                
-                lastNoteTime = time;
-                //outputs[GATE_OUTPUT].setVoltage(0.f);
-                
-            }else{
-                outputs[GATE_OUTPUT].setVoltage(10.f);
-            }
 
-       
-        
-        
-            v_oct = midiToVolts(midiNotes[closestWell]);
-            outputs[VOCT_OUTPUT].setVoltage(v_oct);
-        }else{
-            outputs[GATE_OUTPUT].setVoltage(0.f);
-            closestWell = 0; // Réinitialisation pour les autres filtres
+                outputs[VOCT_OUTPUT].setVoltage(wellNotes.volts[closestWell[c]], c);
+            } else {
+                outputs[GATE_OUTPUT].setVoltage(0.f, c);
+                closestWell[c] = 0; // Réinitialisation pour les autres filtres
+            }
         }
-        
-
-        outputs[OUTPUT].setVoltage(filtred_signal);
+        outputs[GATE_OUTPUT].setChannels(channels);
+        outputs[VOCT_OUTPUT].setChannels(channels);
 
         // Mise à jour du buffer pour affichage
-        buffer_y.push_back(filtred_signal);
-        buffer_x.push_back(signal + noise);
-        if (buffer_y.size() > bufferSize) {
-            buffer_y.erase(buffer_y.begin());
-            buffer_x.erase(buffer_x.begin());
-        }
+        ScopePoint p = {signal + noise, filtred_signal};
+        scope.push(p);
 
-        if(current_filter == 3 ){
-            xi = filtred_signal; // Mise à jour de l'état interne pour le filtre bistable
-        }
         // Mise à jour des lumières
         lights[BISTABLE_LIGHT].setBrightness(current_filter == 3 ? 1.f : 0.f);
         lights[DIODE1_LIGHT].setBrightness(current_filter == 1 ? 1.f : 0.f);	
         lights[DIODE2_LIGHT].setBrightness(current_filter == 2 ? 1.f : 0.f);
+
+        if (timed) {
+            std::chrono::duration<float, std::nano> ns = std::chrono::steady_clock::now() - start;
+            stats.recordTime(ns.count());
+        }
     }
 
  
@@ -311,21 +727,73 @@ struct RSModule : Module {
 
 // === Affichage graphique du potentiel ===
 
+// Axes et courbe du potentiel, rendus dans un FramebufferWidget
+struct PotentialCurve : Widget {
+    std::vector<Vec> segments; // Paires de points (début, fin) déjà à l'échelle
+
+    void draw(const DrawArgs& args) override {
+        float W = box.size.x;
+        float H = box.size.y;
+
+        nvgBeginPath(args.vg);
+        nvgMoveTo(args.vg, 0, H / 2.f);
+        nvgLineTo(args.vg, W, H / 2.f);
+        nvgMoveTo(args.vg, W / 2.f, 0);
+        nvgLineTo(args.vg, W / 2.f, H);
+        nvgStrokeColor(args.vg, nvgRGB(180, 180, 180));
+        nvgStrokeWidth(args.vg, 1.0);
+        nvgStroke(args.vg);
+
+        nvgBeginPath(args.vg);
+        nvgStrokeColor(args.vg, nvgRGB(0x00, 0xff, 0x00));
+        nvgStrokeWidth(args.vg, 1.5);
+        for (size_t i = 0; i + 1 < segments.size(); i += 2) {
+            nvgMoveTo(args.vg, segments[i].x, segments[i].y);
+            nvgLineTo(args.vg, segments[i + 1].x, segments[i + 1].y);
+        }
+        nvgStroke(args.vg);
+    }
+};
+
 struct GraphDisplay : Widget {
     RSModule* module;
     Vec position;
     Vec size;
 
+    FramebufferWidget* fb;
+    PotentialCurve* curve;
+
+    // Paramètres de la courbe en cache
+    float curveThreshold = NAN, curveXB = NAN, curveGain = NAN, curveTime = NAN;
+    int curveNum = -1, curveFilter = -1, curveShape = -1;
+    float curveAsymmetry = 0.f;
+
     float rate = 1.f; // Taux de rafraîchissement du graphique
-    float lastUpdateTime = 0.f;
+    int64_t lastUpdateFrame = 0;
 
     float lcy = 0.f; // Position y du cercle de la position max
     float lcx = 0.f; // Position x du cercle de la position max
 
+    std::vector<ScopePoint> scope; // Copie de la trajectoire côté UI
+
     GraphDisplay(RSModule* module, Vec pos, Vec size)
         : module(module), position(pos), size(size) {
         this->box.pos = pos;
         this->box.size = size;
+        scope.resize(RSModule::SCOPE_CAPACITY);
+
+        fb = new FramebufferWidget;
+        fb->box.size = size;
+        addChild(fb);
+        curve = new PotentialCurve;
+        curve->box.size = size;
+        fb->addChild(curve);
+    }
+
+    // Position extrême de la trajectoire récente
+    float getScopeMax(bool filtred) {
+        size_t n = module->scope.snapshot(scope.data(), std::min((size_t)module->scopeLength, scope.size()));
+        return Max(scope.data(), n, filtred);
     }
 
     float getFiltreProfil(float x) {
@@ -340,72 +808,146 @@ struct GraphDisplay : Widget {
         } else if (current_filter == 2) {
             return rubber(x, threshold);
         } else if (current_filter == 3) {
-            return multi_well_potential(x, module->params[RSModule::DYNAMIC_well_NUM].getValue(), XB);
+            if (curveShape == POTENTIAL_MULTI_WELL)
+                return multi_well_potential(x, curveNum, XB);
+            MultiWellCoefs<float> k;
+            k.set(curveNum, XB);
+            k.setAsymmetry(curveAsymmetry);
+            return potential_simd(curveShape, x, k);
         }
         return 0.f;
     }
 
-    void draw(const DrawArgs& args) override {
-        if (!module) return;
-
-        float threshold = module->params[RSModule::STATIC_THRESHOLD].getValue();
-        float XB = module->params[RSModule::DYNAMIC_well_POS].getValue();
-        float gain = module->params[RSModule::GAIN_PARAM].getValue();
-        float time = module->params[RSModule::TIME_PARAM].getValue();
-        int Num = (int)module->params[RSModule::DYNAMIC_well_NUM].getValue();
+    // Recalcul de la courbe, seulement quand un de ses paramètres change
+    void step() override {
+        if (module) {
+            float threshold = module->params[RSModule::STATIC_THRESHOLD].getValue();
+            float XB = module->params[RSModule::DYNAMIC_well_POS].getValue();
+            float gain = module->params[RSModule::GAIN_PARAM].getValue();
+            float time = module->params[RSModule::TIME_PARAM].getValue();
+            int Num = (int)module->params[RSModule::DYNAMIC_well_NUM].getValue();
+            int filter = module->current_filter;
+            int shape = module->potentialShape;
+            float asymmetry = module->params[RSModule::POTENTIAL_ASYMMETRY_PARAM].getValue();
+
+            if (threshold != curveThreshold || XB != curveXB || gain != curveGain || time != curveTime
+                || Num != curveNum || filter != curveFilter || shape != curveShape || asymmetry != curveAsymmetry) {
+                curveThreshold = threshold;
+                curveXB = XB;
+                curveGain = gain;
+                curveTime = time;
+                curveNum = Num;
+                curveFilter = filter;
+                curveShape = shape;
+                curveAsymmetry = asymmetry;
+                updateCurve();
+                fb->setDirty();
+            }
+        }
+        Widget::step();
+    }
 
+    void updateCurve() {
         float W = size.x;
         float H = size.y;
         float x_center = W / 2.f;
         float y_center = H / 2.f;
 
-        nvgBeginPath(args.vg);
-        nvgMoveTo(args.vg, 0, y_center);
-        nvgLineTo(args.vg, W, y_center);
-        nvgMoveTo(args.vg, x_center, 0);
-        nvgLineTo(args.vg, x_center, H);
-        nvgStrokeColor(args.vg, nvgRGB(180, 180, 180));
-        nvgStrokeWidth(args.vg, 1.0);
-        nvgStroke(args.vg);
-
-        nvgBeginPath(args.vg);
-        nvgStrokeColor(args.vg, nvgRGB(0x00, 0xff, 0x00));
-        nvgStrokeWidth(args.vg, 1.5);
-
         int N = 1000;
-        float domain = (module->current_filter != 3) ? threshold + 5 : 2*Num*XB + 5;
+        float domain = (curveFilter != 3) ? curveThreshold + 5 : 2*potential_wells(curveShape, curveNum)*curveXB + 5;
         float x1, x2, y1, y2;
 
+        curve->segments.clear();
         for (int i = 0; i < N; ++i) {
             x1 = -domain + 2.f * domain * i / N;
             x2 = -domain + 2.f * domain * (i + 1) / N;
             y1 = getFiltreProfil(x1);
             y2 = getFiltreProfil(x2);
 
-            x1 = x_center + x1 * time;
-            x2 = x_center + x2 * time;
-            y1 = y_center - y1 * gain;
-            y2 = y_center - y2 * gain;
+            x1 = x_center + x1 * curveTime;
+            x2 = x_center + x2 * curveTime;
+            y1 = y_center - y1 * curveGain;
+            y2 = y_center - y2 * curveGain;
 
             if ((y1 <= (box.pos[1] - H / 4 + H) && y1 >= box.pos[1] - H / 4) ||
                 (y2 <= (box.pos[1] - H / 4 + H) && y2 >= box.pos[1] - H / 4)) {
-                nvgMoveTo(args.vg, x1, y1);
-                nvgLineTo(args.vg, x2, y2);
+                curve->segments.push_back(Vec(x1, y1));
+                curve->segments.push_back(Vec(x2, y2));
             }
         }
-        nvgStroke(args.vg);
+    }
+
+    // Histogramme d'occupation (canal 0) sous la courbe, et durée moyenne avant
+    // évasion de chaque puits visité, lus dans la dernière publication
+    void drawOccupancy(const DrawArgs& args, std::shared_ptr<window::Font> font, float time) {
+        OccupancyHistogram::Snapshot s = module->occupancy.snapshot();
+        float W = size.x;
+        float H = size.y;
+        float width = (s.hi - s.lo) / OccupancyHistogram::BINS;
+
+        nvgBeginPath(args.vg);
+        nvgFillColor(args.vg, nvgRGBA(0x00, 0xa0, 0xff, 0x60));
+        for (int b = 0; b < OccupancyHistogram::BINS; ++b) {
+            if (s.density[b] <= 0.f)
+                continue;
+            float x = W / 2.f + (s.lo + b * width) * time;
+            float h = s.density[b] * H * 0.4f;
+            nvgRect(args.vg, x, H - h, width * time, h);
+        }
+        nvgFill(args.vg);
+
+        if (!font || font->handle < 0)
+            return;
+        nvgFontFaceId(args.vg, font->handle);
+        nvgFontSize(args.vg, 9.f);
+        nvgFillColor(args.vg, nvgRGB(0x80, 0xd0, 0xff));
+        nvgTextAlign(args.vg, NVG_ALIGN_CENTER | NVG_ALIGN_BOTTOM);
+        for (int w = 0; w < OccupancyHistogram::MAX_WELLS; ++w) {
+            if (s.escapeTime[w] <= 0.f)
+                continue;
+            float x = W / 2.f + s.position[w] * time;
+            if (x >= 0.f && x <= W)
+                nvgText(args.vg, x, H - 2.f, string::f("%.2gs", s.escapeTime[w]).c_str(), NULL);
+        }
+    }
+
+    void draw(const DrawArgs& args) override {
+        if (!module) return;
+
+        // Courbe en cache
+        Widget::draw(args);
+
+        // Mesure de la résonance (canal 0)
+        std::shared_ptr<window::Font> font = APP->window->loadFont(asset::system("res/fonts/ShareTechMono-Regular.ttf"));
+        if (font && font->handle >= 0) {
+            std::string label = (module->meterMode == RSModule::METER_SPA) ? "SPA" : "SNR";
+            nvgFontFaceId(args.vg, font->handle);
+            nvgFontSize(args.vg, 11.f);
+            nvgFillColor(args.vg, nvgRGB(180, 180, 180));
+            nvgTextAlign(args.vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+            nvgText(args.vg, 4.f, 4.f, string::f("%s %+.1f dB", label.c_str(), module->meterDb).c_str(), NULL);
+        }
+
+        float gain = module->params[RSModule::GAIN_PARAM].getValue();
+        float time = module->params[RSModule::TIME_PARAM].getValue();
+
+        float W = size.x;
+        float H = size.y;
+        float x_center = W / 2.f;
+        float y_center = H / 2.f;
+
+        if (module->current_filter == 3)
+            drawOccupancy(args, font, time);
 
         // Cercle pour la position max
         
         float mode = module->params[RSModule::MODE_PARAM].getValue();
         if (mode > 0.5f && module->current_filter == 3) {
-            if( (module->time - lastUpdateTime) >= module->params[RSModule::NOTE_RATE].getValue()) {
+            if( (module->frame - lastUpdateFrame) >= module->noteInterval) {
             
             
                 bool bistable_enabled = (module->current_filter == 3);
-                float cx = bistable_enabled? Max(module->buffer_y): Max(module->buffer_x);
-
-                //std::cout <<bistable_enabled<< " cx: " << cx << "   bx: "<<Max(module->buffer_x)<<"  by: "<<Max(module->buffer_y)<< std::endl;
+                float cx = getScopeMax(bistable_enabled);
 
             
                 float cy = getFiltreProfil(cx);
@@ -414,7 +956,7 @@ struct GraphDisplay : Widget {
                 lcy = y_center - cy * gain;
 
                 
-                lastUpdateTime = module->time;
+                lastUpdateFrame = module->frame;
             }else{
                 /*
                 (lcy <= (box.pos[1] - H / 4 + H) && lcy >= box.pos[1] - H / 4) ||
@@ -428,7 +970,7 @@ struct GraphDisplay : Widget {
             }
         } else {
             bool bistable_enabled = (module->current_filter == 3);
-            float cx = bistable_enabled? Max(module->buffer_y): Max(module->buffer_x);
+            float cx = getScopeMax(bistable_enabled);
 
         
             float cy = getFiltreProfil(cx);
@@ -447,6 +989,14 @@ struct GraphDisplay : Widget {
 
 // === Widget de l'interface graphique du module ===
 
+// Réglage depuis le menu d'un paramètre sans emplacement sur le panneau
+struct ParamSlider : ui::Slider {
+    ParamSlider(ParamQuantity* q) {
+        quantity = q;
+        box.size.x = 200.f;
+    }
+};
+
 struct RSModuleWidget : ModuleWidget {
     RSModuleWidget(RSModule* module) {
         setModule(module);
@@ -502,6 +1052,111 @@ struct RSModuleWidget : ModuleWidget {
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(55.8495, 114.64)), module, RSModule::GATE_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(79.0685, 114.64)), module, RSModule::OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(97.8245, 114.64)), module, RSModule::VOCT_OUTPUT));
+
+        // Rétroaction retardée (DELAY, FEEDBACK)
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(61.1, 84.0)), module, RSModule::DELAY_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(84.0, 84.0)), module, RSModule::FEEDBACK_PARAM));
+
+        // Mesures (SNR, ESCAPE), libellées sous les prises
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(61.1, 101.0)), module, RSModule::SNR_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(84.0, 101.0)), module, RSModule::ESCAPE_OUTPUT));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        RSModule* module = getModule<RSModule>();
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createIndexPtrSubmenuItem("Integrator",
+            {"Euler", "Heun (adaptive)", "RK4 (adaptive)", "Semi-implicit"},
+            &module->integrator));
+
+        menu->addChild(createIndexPtrSubmenuItem("Potential",
+            {"Multi-well", "Asymmetric bistable", "Tristable", "Washboard (periodic)"},
+            &module->potentialShape));
+        menu->addChild(new ParamSlider(module->paramQuantities[RSModule::POTENTIAL_ASYMMETRY_PARAM]));
+
+        menu->addChild(createIndexPtrSubmenuItem("Threshold anti-aliasing",
+            {"Off", "ADAA, 1st order", "ADAA, 2nd order", "2x oversampling", "4x oversampling"},
+            &module->antialiasing));
+
+        menu->addChild(createIndexPtrSubmenuItem("Resonance meter",
+            {"Signal-to-noise ratio", "Spectral power amplification"},
+            &module->meterMode));
+
+        static const std::vector<int> scopeLengths = {512, 1024, 2048, 4096, 8192};
+        std::vector<std::string> scopeLabels;
+        for (int n : scopeLengths)
+            scopeLabels.push_back(std::to_string(n) + " samples");
+        menu->addChild(createIndexSubmenuItem("Trajectory length", scopeLabels,
+            [=]() {
+                size_t i = 0;
+                while (i + 1 < scopeLengths.size() && scopeLengths[i] < module->scopeLength)
+                    ++i;
+                return i;
+            },
+            [=](size_t i) {
+                module->scopeLength = scopeLengths[i];
+            }
+        ));
+
+        menu->addChild(new MenuSeparator);
+        std::vector<std::string> scaleLabels;
+        for (int i = 0; i < SCALES_LEN; ++i)
+            scaleLabels.push_back(SCALES[i].name);
+        menu->addChild(createIndexPtrSubmenuItem("Scale", scaleLabels, &module->scale));
+        menu->addChild(createIndexPtrSubmenuItem("Root",
+            std::vector<std::string>(NOTE_NAMES, NOTE_NAMES + 12), &module->root));
+        menu->addChild(createBoolPtrMenuItem("Legacy pitch (5/12 V per semitone)", "", &module->legacyPitch));
+
+        menu->addChild(new MenuSeparator);
+        static const std::vector<int> ensembleSizes = {0, 4, 8, 16, 32, 64};
+        std::vector<std::string> ensembleLabels;
+        for (int n : ensembleSizes)
+            ensembleLabels.push_back(n == 0 ? "Off (single unit)" : std::to_string(n) + " units");
+        menu->addChild(createIndexSubmenuItem("Ensemble", ensembleLabels,
+            [=]() {
+                size_t i = 0;
+                while (i + 1 < ensembleSizes.size() && ensembleSizes[i] < module->ensembleUnits)
+                    ++i;
+                return i;
+            },
+            [=](size_t i) {
+                module->ensembleUnits = ensembleSizes[i];
+            }
+        ));
+        menu->addChild(createIndexPtrSubmenuItem("Ensemble coupling",
+            {"None", "Ring (nearest neighbours)", "Global (all-to-all)"},
+            &module->ensembleCoupling));
+        menu->addChild(new ParamSlider(module->paramQuantities[RSModule::ENSEMBLE_COUPLING_PARAM]));
+        menu->addChild(new ParamSlider(module->paramQuantities[RSModule::ENSEMBLE_NOISE_PARAM]));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createSubmenuItem("Statistics", "", [=](Menu* menu) {
+            RSStats::Snapshot s = module->stats.snapshot();
+            menu->addChild(createMenuLabel(string::f("Over %.1f s", s.seconds)));
+            menu->addChild(createMenuLabel(string::f("Cost: %.0f ns/sample", s.nsPerSample)));
+            menu->addChild(createMenuLabel(string::f("Well transitions: %.2f /s per channel", s.transitionRate())));
+            for (int w = 0; w < RSStats::MAX_WELLS; ++w) {
+                if (s.visits[w])
+                    menu->addChild(createMenuLabel(string::f("Well %d: mean residence %.3f s (%llu visits)",
+                        w + 1, s.meanResidence(w), (unsigned long long)s.visits[w])));
+            }
+            menu->addChild(createMenuLabel(string::f("Clamp hits at ±5 V: %llu", (unsigned long long)s.clampHits)));
+            menu->addChild(createMenuLabel(string::f("NaN/Inf inputs: %llu", (unsigned long long)s.nonFinite)));
+            menu->addChild(new MenuSeparator);
+            menu->addChild(createMenuItem("Copy as JSON", "", [=]() {
+                json_t* rootJ = module->statsToJson();
+                char* text = json_dumps(rootJ, JSON_INDENT(2) | JSON_REAL_PRECISION(6));
+                json_decref(rootJ);
+                if (text) {
+                    system::setClipboard(text);
+                    std::free(text);
+                }
+            }));
+            menu->addChild(createMenuItem("Reset", "", [=]() {
+                module->stats.requestReset();
+            }));
+        }));
     }
 };
 
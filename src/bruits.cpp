@@ -0,0 +1,110 @@
+#include <cmath>
+#include "bruits.hpp"
+
+// Bruit blanc gaussien
+float generateWhiteNoise(GaussianGenerator& rng) {
+    return rng.gaussian();
+}
+
+// Bruit rouge (Brownian)
+float generateRedNoise(GaussianGenerator& rng, float& last) {
+    float white = rng.gaussian() * 0.02f; // facteur pour éviter la dérive
+    last += white;
+    // Clamp pour éviter les débordements
+    if (last > 5.f) last = 5.f;
+    if (last < -5.f) last = -5.f;
+    return last;
+}
+
+// Velvet noise (distribution impulsionnelle aléatoire)
+float generateVelvetNoise(float density, float sampleTime, GaussianGenerator& rng, VelvetState& state) {
+    state.phase += density * sampleTime;
+    bool pulse = false;
+    if (state.phase >= 1.f) {
+        // Impulsion tombée entre le dernier échantillon et la fin de la période
+        pulse = state.pending;
+        // Nouvelle période : position de l'impulsion tirée au hasard
+        state.phase -= std::floor(state.phase);
+        state.pulseAt = rng.engine.uniform();
+        state.pending = true;
+    }
+    if (!pulse && state.pending && state.phase >= state.pulseAt) {
+        state.pending = false;
+        pulse = true;
+    }
+    if (pulse) {
+        // Impulsion aléatoire +1 ou -1
+        return (rng.engine.next() & 0x80000000u) ? 1.f : -1.f;
+    }
+    return 0.f;
+}
+
+rack::simd::float_4 generateWhiteNoise_simd(GaussianGenerator& rng) {
+    return rng.gaussian4();
+}
+
+rack::simd::float_4 generateRedNoise_simd(GaussianGenerator& rng, rack::simd::float_4& last) {
+    last += rng.gaussian4() * 0.02f;
+    last = rack::simd::fmin(rack::simd::fmax(last, -5.f), 5.f);
+    return last;
+}
+
+rack::simd::float_4 generateVelvetNoise_simd(float density, float sampleTime, GaussianGenerator& rng, VelvetState state[4]) {
+    rack::simd::float_4 out;
+    for (int l = 0; l < 4; ++l)
+        out[l] = generateVelvetNoise(density, sampleTime, rng, state[l]);
+    return out;
+}
+
+void VelvetSequence::generate(int length, float density, float sampleRate, uint64_t seed) {
+    this->length = std::max(length, 0);
+    delays.clear();
+    signs.clear();
+    Xoshiro128 rng(seed);
+    double period = sampleRate / std::fmax(density, 1.f);
+    int last = -1;
+    for (double start = 0.0; start < this->length; start += period) {
+        // Deux impulsions ne tombent jamais sur le même échantillon
+        int k = std::max((int)(start + rng.uniform() * period), last + 1);
+        if (k >= this->length) break;
+        last = k;
+        delays.push_back(k);
+        signs.push_back((uint16_t)(rng.next() >> 16));
+    }
+    gain = delays.empty() ? 0.f : 1.f / std::sqrt((float)delays.size());
+}
+
+void ColoredNoiseFilter::setSlope(float alpha, float sampleRate) {
+    // Aux bornes les séries de report divergent : alpha reste à l'intérieur
+    double a = std::fmin(std::fmax((double)alpha, 1e-3), 2.0 - 1e-3);
+    double q = std::pow((double)POLE_RATIO, -a / 2);        // Rapport entre poids voisins
+    double s = std::pow((double)POLE_RATIO, -(1.0 - a / 2)); // Rapport des termes reportés en dessous
+
+    double pole[POLES], weight[POLES], wd;
+    double wk = 1.0;
+    for (int k = 0; k < POLES; ++k) {
+        double f = POLE_MIN_FREQ * std::pow((double)POLE_RATIO, k);
+        pole[k] = std::exp(-2.0 * M_PI * f / sampleRate);
+        weight[k] = wk;
+        wk *= q;
+    }
+    weight[0] *= 1.0 / (1.0 - s);
+    wd = weight[POLES - 1] * q / (1.0 - q);
+
+    // Variance de la sortie pour un bruit blanc de variance unité :
+    // E[y_i y_j] = b_i b_j / (1 - a_i a_j) et E[x y_k] = b_k
+    double var = wd * wd;
+    for (int i = 0; i < POLES; ++i) {
+        double bi = 1.0 - pole[i];
+        var += 2.0 * wd * weight[i] * bi;
+        for (int j = 0; j < POLES; ++j)
+            var += weight[i] * weight[j] * bi * (1.0 - pole[j]) / (1.0 - pole[i] * pole[j]);
+    }
+    double norm = 1.0 / std::sqrt(var);
+
+    for (int k = 0; k < POLES; ++k) {
+        b[k] = float(1.0 - pole[k]);
+        w[k] = float(weight[k] * norm);
+    }
+    direct = float(wd * norm);
+}
@@ -0,0 +1,265 @@
+#ifndef BRUITS_HPP
+#define BRUITS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "rng.hpp"
+
+// Densité d'impulsions du velvet noise par défaut (par seconde)
+static const float VELVET_DENSITY = 1000.f;
+
+// État d'un velvet noise : une impulsion de signe aléatoire par période de
+// 1/densité, placée au hasard dans la période
+struct VelvetState {
+    float phase = 1.f;    // Position dans la période courante, en périodes
+    float pulseAt = 0.f;  // Position de l'impulsion dans la période
+    bool pending = false; // Impulsion de la période pas encore émise
+};
+
+// Chaque instance fournit son générateur et son état : aucun état partagé
+float generateWhiteNoise(GaussianGenerator& rng);
+float generateRedNoise(GaussianGenerator& rng, float& last);
+float generateVelvetNoise(float density, float sampleTime, GaussianGenerator& rng, VelvetState& state);
+
+// Versions quatre voies : chaque voie reçoit des tirages distincts du générateur,
+// donc des flux indépendants
+rack::simd::float_4 generateWhiteNoise_simd(GaussianGenerator& rng);
+rack::simd::float_4 generateRedNoise_simd(GaussianGenerator& rng, rack::simd::float_4& last);
+rack::simd::float_4 generateVelvetNoise_simd(float density, float sampleTime, GaussianGenerator& rng, VelvetState state[4]);
+
+// Séquence de velvet noise fixe : un FIR épars dont les coefficients valent
+// +1 ou -1. Les positions des impulsions sont communes à tous les canaux, le
+// signe de chaque impulsion est tiré pour chaque canal : une seule liste pour
+// toute la polyphonie, et des entrées identiques sortent décorrélées.
+struct VelvetSequence {
+    static const int MAX_CHANNELS = 16;
+
+    std::vector<int> delays;     // Retards des impulsions, croissants
+    std::vector<uint16_t> signs; // Bit c : impulsion négative pour le canal c
+    int length = 0;              // Longueur du FIR, en échantillons
+    float gain = 0.f;            // 1/sqrt(impulsions) : réponse d'énergie unité
+
+    // Une impulsion par période de sampleRate/density échantillons, sur
+    // length échantillons. N'alloue que si la séquence dépasse la précédente.
+    void generate(int length, float density, float sampleRate, uint64_t seed);
+};
+
+// Convolution par une VelvetSequence, calculée par additions et soustractions
+// des seuls échantillons retardés aux positions des impulsions : coût
+// proportionnel au nombre d'impulsions, et non à la longueur du filtre.
+// T = float (un canal) ou rack::simd::float_4 (quatre canaux consécutifs).
+template <typename T>
+struct VelvetFir {
+    static const int LANES = sizeof(T) / sizeof(float);
+
+    VelvetFir() {
+        // Signes des voies pour chaque combinaison de bits
+        for (int m = 0; m < (1 << LANES); ++m) {
+            float v[LANES];
+            for (int l = 0; l < LANES; ++l)
+                v[l] = ((m >> l) & 1) ? -1.f : 1.f;
+            std::memcpy(&sign[m], v, sizeof(T));
+        }
+    }
+
+    // Ligne à retard d'au moins length échantillons, arrondie à une puissance
+    // de deux ; ne réalloue que si la taille change
+    void setLength(int length) {
+        size_t c = 1;
+        while (c < (size_t)length)
+            c <<= 1;
+        if (c == history.size())
+            return;
+        history.assign(c, T(0.f));
+        mask = c - 1;
+        pos = 0;
+    }
+
+    int maxLength() const {
+        return (int)history.size();
+    }
+
+    void clear() {
+        std::fill(history.begin(), history.end(), T(0.f));
+    }
+
+    // Canaux first à first + LANES - 1 de la séquence ; silence tant que la
+    // ligne est plus courte que la séquence
+    T process(const VelvetSequence& seq, int first, T x) {
+        if (history.empty() || maxLength() < seq.length)
+            return T(0.f);
+        history[pos] = x;
+        T sum = 0.f;
+        for (size_t i = 0; i < seq.delays.size(); ++i)
+            sum += history[(pos - seq.delays[i]) & mask] * sign[(seq.signs[i] >> first) & ((1 << LANES) - 1)];
+        pos = (pos + 1) & mask;
+        return sum * seq.gain;
+    }
+
+private:
+    std::vector<T> history;
+    size_t mask = 0;
+    size_t pos = 0;
+    T sign[1 << LANES];
+};
+
+// Bruit coloré de densité spectrale 1/f^alpha, alpha continu de 0 (blanc) à
+// 1 (rose) et 2 (brun). Un même bruit blanc alimente un banc de filtres passe-bas
+// du premier ordre dont les coupures sont espacées d'une octave et demie : le
+// poids f_k^(-alpha/2) de chaque filtre donne la pente voulue entre POLE_MIN_FREQ
+// et la plus haute coupure. Au-dessus, un terme direct prolonge la série ; en
+// dessous, le reste de la série est reporté sur le premier filtre, le spectre
+// devient plat et la sortie ne dérive pas. Coût : POLES filtres par échantillon.
+struct ColoredNoiseFilter {
+    static const int POLES = 8;
+    static constexpr float POLE_MIN_FREQ = 10.f;
+    static constexpr float POLE_RATIO = 2.8284271f; // 1,5 octave
+
+    float b[POLES];  // Coefficients des passe-bas : y += (x - y) * b
+    float w[POLES];  // Poids des sorties des filtres
+    float direct;    // Poids du bruit blanc
+
+    ColoredNoiseFilter() {
+        setSlope(1.f, 44100.f);
+    }
+
+    // Calcule poids et coefficients, puis normalise la sortie à variance unité
+    void setSlope(float alpha, float sampleRate);
+};
+
+template <typename T>
+struct ColoredNoise {
+    T y[ColoredNoiseFilter::POLES];
+
+    ColoredNoise() {
+        reset();
+    }
+
+    void reset() {
+        for (int k = 0; k < ColoredNoiseFilter::POLES; ++k)
+            y[k] = 0.f;
+    }
+
+    T process(const ColoredNoiseFilter& f, T white) {
+        T out = white * f.direct;
+        for (int k = 0; k < ColoredNoiseFilter::POLES; ++k) {
+            y[k] += (white - y[k]) * f.b[k];
+            out += y[k] * f.w[k];
+        }
+        return out;
+    }
+};
+
+// Bruit Perlin à gradients hachés : aucune table, l'état se résume à la graine.
+// La phase est exprimée en cellules du réseau, en double, et reste dans
+// [0, PERIOD) : le réseau est périodique de période PERIOD, donc le bouclage
+// est sans raccord tant que la lacunarité est entière.
+class Perlin{
+public:
+    static constexpr int PERIOD = 65536;
+    static constexpr int MAX_OCTAVES = 8;
+
+    explicit Perlin(uint32_t seed = 0) {
+        setSeed(seed);
+        setOctaves(5, 0.5f, 2.0f);
+    }
+
+    void setSeed(uint32_t seed) {
+        key = hash(seed);
+    }
+
+    // Fréquences et amplitudes (déjà normalisées) de chaque octave
+    void setOctaves(int octaves, float persistence, float lacunarity) {
+        numOctaves = std::max(1, std::min(octaves, (int)MAX_OCTAVES));
+        float amplitude = 1.0f;
+        double frequency = 1.0;
+        float maxAmplitude = 0.0f;
+        for (int i = 0; i < numOctaves; ++i) {
+            octaveFreq[i] = frequency;
+            octaveAmp[i] = amplitude;
+            maxAmplitude += amplitude;
+            amplitude *= persistence;
+            frequency *= lacunarity;
+        }
+        for (int i = 0; i < numOctaves; ++i)
+            octaveAmp[i] /= maxAmplitude;
+    }
+
+    // Avance la phase de delta cellules, modulo PERIOD
+    static double advance(double phase, double delta) {
+        phase += delta;
+        if (phase >= PERIOD || phase < 0.0)
+            phase -= PERIOD * std::floor(phase / PERIOD);
+        return phase;
+    }
+
+    float sample(double phase, int channel = 0) const {
+        float total = 0.0f;
+        for (int i = 0; i < numOctaves; ++i) {
+            double x = phase * octaveFreq[i];
+            double x0 = std::floor(x);
+            float t = float(x - x0);
+            uint32_t cell = lattice(x0);
+            total += perlin(t, gradient(cell, channel), gradient(cell + 1, channel)) * octaveAmp[i];
+        }
+        return total;
+    }
+
+    // Quatre canaux firstChannel..firstChannel+3 à la même phase : la position
+    // dans le réseau est commune, seuls les gradients diffèrent
+    rack::simd::float_4 sample_simd(double phase, int firstChannel) const {
+        rack::simd::float_4 total = 0.f;
+        for (int i = 0; i < numOctaves; ++i) {
+            double x = phase * octaveFreq[i];
+            double x0 = std::floor(x);
+            float t = float(x - x0);
+            uint32_t cell = lattice(x0);
+            rack::simd::float_4 g0, g1;
+            for (int l = 0; l < 4; ++l) {
+                g0[l] = gradient(cell, firstChannel + l);
+                g1[l] = gradient(cell + 1, firstChannel + l);
+            }
+            total += perlin(t, g0, g1) * octaveAmp[i];
+        }
+        return total;
+    }
+
+private:
+    uint32_t key = 0;
+    int numOctaves = 1;
+    double octaveFreq[MAX_OCTAVES];
+    float octaveAmp[MAX_OCTAVES];
+
+    // Hachage 32 bits bijectif (lowbias32)
+    static uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Cellule modulo PERIOD
+    static uint32_t lattice(double x0) {
+        return uint32_t(int64_t(x0)) & (PERIOD - 1);
+    }
+
+    // Gradient dans [-1, 1). Le canal occupe les bits de poids fort de la clé
+    // et le hachage est bijectif, donc deux canaux ne partagent aucun gradient.
+    float gradient(uint32_t cell, int channel) const {
+        uint32_t k = (cell & (PERIOD - 1)) | (uint32_t(channel) << 16);
+        return int32_t(hash(k ^ key)) * (1.f / 2147483648.f);
+    }
+
+    template <typename T>
+    static T perlin(float t, T g0, T g1) {
+        float fade_t = t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+        return (1.0f - fade_t) * t * g0 + fade_t * (t - 1.0f) * g1;
+    }
+};
+
+#endif // BRUITS_HPP
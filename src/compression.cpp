@@ -0,0 +1,82 @@
+#include <cmath>
+#include "compression.hpp"
+
+float LOG2_TABLE[DB_TABLE_SIZE + 1];
+float EXP2_TABLE[DB_TABLE_SIZE + 1];
+
+// Remplissage des tables au chargement du plugin
+static struct DbTablesInit {
+    DbTablesInit() {
+        for (int i = 0; i <= DB_TABLE_SIZE; ++i) {
+            double x = (double)i / DB_TABLE_SIZE;
+            LOG2_TABLE[i] = (float)std::log2(1.0 + x);
+            EXP2_TABLE[i] = (float)std::exp2(x);
+        }
+    }
+} dbTablesInit;
+
+void CompressorSettings::setTimes(float attackTime, float releaseTime, float sampleRate) {
+    attack = 1.f - std::exp(-1.f / (std::fmax(attackTime, 1e-5f) * sampleRate));
+    release = 1.f - std::exp(-1.f / (std::fmax(releaseTime, 1e-5f) * sampleRate));
+    rms = 1.f - std::exp(-1.f / (RMS_WINDOW * sampleRate));
+}
+
+void BiquadCoefs::setLane(int lane, Type type, float f, float sampleRate) {
+    double b[3] = {1.0, 0.0, 0.0}, a[2] = {0.0, 0.0};
+    if (type == ZERO) {
+        b[0] = 0.0;
+    }
+    else if (type != IDENTITY) {
+        // Transformation bilinéaire avec prédistorsion : toutes les sections
+        // d'une même coupure partagent K, les sommes LP + HP restent exactes
+        double K = std::tan(M_PI * std::fmin(f, 0.45f * sampleRate) / sampleRate);
+        double q = M_SQRT1_2;
+        double norm = 1.0 / (1.0 + K / q + K * K);
+        a[0] = 2.0 * (K * K - 1.0) * norm;
+        a[1] = (1.0 - K / q + K * K) * norm;
+        if (type == LOWPASS) {
+            b[0] = K * K * norm;
+            b[1] = 2.0 * b[0];
+            b[2] = b[0];
+        }
+        else if (type == HIGHPASS) {
+            b[0] = norm;
+            b[1] = -2.0 * norm;
+            b[2] = norm;
+        }
+        else {
+            b[0] = a[1];
+            b[1] = a[0];
+            b[2] = 1.0;
+        }
+    }
+    b0[lane] = (float)b[0];
+    b1[lane] = (float)b[1];
+    b2[lane] = (float)b[2];
+    a1[lane] = (float)a[0];
+    a2[lane] = (float)a[1];
+}
+
+void CrossoverCoefs::set(int bands, float f1, float f2, float f3, float sampleRate) {
+    this->bands = bands;
+    split.setLane(0, BiquadCoefs::LOWPASS, f2, sampleRate);
+    split.setLane(1, BiquadCoefs::HIGHPASS, f2, sampleRate);
+    split.setLane(2, BiquadCoefs::ZERO, 0.f, sampleRate);
+    split.setLane(3, BiquadCoefs::ZERO, 0.f, sampleRate);
+    band.setLane(0, BiquadCoefs::LOWPASS, f1, sampleRate);
+    band.setLane(1, BiquadCoefs::HIGHPASS, f1, sampleRate);
+    allpass.setLane(2, BiquadCoefs::ALLPASS, f1, sampleRate);
+    allpass.setLane(3, BiquadCoefs::ALLPASS, f1, sampleRate);
+    if (bands >= 4) {
+        band.setLane(2, BiquadCoefs::LOWPASS, f3, sampleRate);
+        band.setLane(3, BiquadCoefs::HIGHPASS, f3, sampleRate);
+        allpass.setLane(0, BiquadCoefs::ALLPASS, f3, sampleRate);
+        allpass.setLane(1, BiquadCoefs::ALLPASS, f3, sampleRate);
+    }
+    else {
+        band.setLane(2, BiquadCoefs::IDENTITY, 0.f, sampleRate);
+        band.setLane(3, BiquadCoefs::ZERO, 0.f, sampleRate);
+        allpass.setLane(0, BiquadCoefs::IDENTITY, 0.f, sampleRate);
+        allpass.setLane(1, BiquadCoefs::IDENTITY, 0.f, sampleRate);
+    }
+}
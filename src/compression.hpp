@@ -0,0 +1,248 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+
+// === Conversions dB par tables ===
+// log2 et exp2 lus dans des tables de 2^DB_TABLE_BITS points sur une octave,
+// avec interpolation linéaire : erreur < 1e-4 dB, sans log ni exp par échantillon.
+
+static const int DB_TABLE_BITS = 8;
+static const int DB_TABLE_SIZE = 1 << DB_TABLE_BITS;
+extern float LOG2_TABLE[DB_TABLE_SIZE + 1]; // log2(1 + i / DB_TABLE_SIZE)
+extern float EXP2_TABLE[DB_TABLE_SIZE + 1]; // 2^(i / DB_TABLE_SIZE)
+
+// Tension de référence du 0 dB : niveau crête nominal des signaux audio de Rack
+static const float DB_REFERENCE = 5.f;
+static const float DB_PER_OCTAVE = 6.0205999f;  // 20 log10(2)
+static const float LOG2_DB_REFERENCE = 2.3219281f; // log2(5)
+
+inline float fastLog2(float x) {
+    x = std::fmax(x, 1e-10f); // -200 dB, loin des dénormaux
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int e = (int)((bits >> 23) & 0xff) - 127;
+    uint32_t m = bits & 0x7fffff;
+    int i = m >> (23 - DB_TABLE_BITS);
+    float frac = (m & ((1 << (23 - DB_TABLE_BITS)) - 1)) * (1.f / (1 << (23 - DB_TABLE_BITS)));
+    return e + LOG2_TABLE[i] + (LOG2_TABLE[i + 1] - LOG2_TABLE[i]) * frac;
+}
+
+inline float fastExp2(float y) {
+    y = std::fmin(std::fmax(y, -126.f), 126.f);
+    float fi = std::floor(y);
+    float f = (y - fi) * DB_TABLE_SIZE;
+    int i = (int)f;
+    float frac = f - i;
+    uint32_t bits = (uint32_t)((int)fi + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return (EXP2_TABLE[i] + (EXP2_TABLE[i + 1] - EXP2_TABLE[i]) * frac) * scale;
+}
+
+// Niveau en dB par rapport à DB_REFERENCE, et inverse
+inline float ampToDb(float x) {
+    return DB_PER_OCTAVE * (fastLog2(x) - LOG2_DB_REFERENCE);
+}
+
+inline float dbToAmp(float db) {
+    return fastExp2(db * (1.f / DB_PER_OCTAVE) + LOG2_DB_REFERENCE);
+}
+
+// Gain (facteur) d'un nombre de dB, sans référence
+inline float dbToGain(float db) {
+    return fastExp2(db * (1.f / DB_PER_OCTAVE));
+}
+
+// Versions float_4 : quatre lectures de table par appel coûteraient plus que
+// le calcul. L'exposant est lu dans les bits, la mantisse passe par un polynôme.
+// Écart aux tables < 1e-5 dB.
+
+// Mantisse ramenée dans [√½, √2), puis log2(m) = 2 / ln 2 (t + t³/3 + t⁵/5 + t⁷/7)
+// avec t = (m - 1) / (m + 1), |t| < 0.172
+inline rack::simd::float_4 fastLog2(rack::simd::float_4 x) {
+    using rack::simd::float_4;
+    using rack::simd::int32_4;
+    x = rack::simd::fmax(x, float_4(1e-10f));
+    int32_4 bits = int32_4::cast(x);
+    int32_4 e = (bits - int32_4(0x3f3504f3)) >> 23; // 0x3f3504f3 : √½
+    float_4 m = float_4::cast(bits - (e << 23));
+    float_4 t = (m - 1.f) / (m + 1.f);
+    float_4 t2 = t * t;
+    return float_4(e) + t * (2.8853901f + t2 * (0.96179669f + t2 * (0.57707802f + t2 * 0.41219858f)));
+}
+
+// 2^y = 2^n 2^f avec n = floor(y + ½), f dans [-½, ½) ; polynôme minimax de 2^f
+inline rack::simd::float_4 fastExp2(rack::simd::float_4 y) {
+    using rack::simd::float_4;
+    using rack::simd::int32_4;
+    y = rack::simd::fmin(rack::simd::fmax(y, float_4(-126.f)), float_4(126.f));
+    float_4 z = y + 0.5f;
+    int32_4 n = int32_4(z); // Troncature, corrigée vers le bas pour z < 0
+    n = n + int32_4::cast(float_4(n) > z);
+    float_4 f = y - float_4(n);
+    float_4 p = 1.535336188e-4f;
+    p = p * f + 1.339887440e-3f;
+    p = p * f + 9.618437358e-3f;
+    p = p * f + 5.550332471e-2f;
+    p = p * f + 2.402264791e-1f;
+    p = p * f + 6.931472029e-1f;
+    p = p * f + 1.f;
+    return p * float_4::cast((n + int32_4(127)) << 23);
+}
+
+// T = float (tables) ou rack::simd::float_4 (polynômes)
+template <typename T>
+T ampToDb_simd(T x) {
+    return DB_PER_OCTAVE * (fastLog2(x) - LOG2_DB_REFERENCE);
+}
+
+template <typename T>
+T dbToGain_simd(T db) {
+    return fastExp2(db * (1.f / DB_PER_OCTAVE));
+}
+
+// === Compresseur ===
+
+enum DetectorMode {
+    DETECTOR_PEAK,
+    DETECTOR_RMS,
+    DETECTOR_MODES_LEN
+};
+
+// Réglages du compresseur, recalculés à la cadence de contrôle
+struct CompressorSettings {
+    static constexpr float RMS_WINDOW = 0.01f; // Fenêtre du détecteur RMS, en secondes
+
+    float threshold = -20.f; // dB
+    float ratio = 4.f;
+    float knee = 6.f;        // Largeur du coude, dB
+    float makeup = 0.f;      // dB
+    int detector = DETECTOR_PEAK;
+    // Coefficients des moyennes exponentielles
+    float attack = 1.f, release = 1.f, rms = 1.f;
+
+    // Temps en secondes
+    void setTimes(float attackTime, float releaseTime, float sampleRate);
+};
+
+// Calcul de gain dans le domaine logarithmique : réduction (dB, <= 0) pour un
+// niveau d'entrée en dB, avec coude progressif de largeur knee
+template <typename T>
+T compressorGain(const CompressorSettings& s, T level) {
+    T over = level - s.threshold;
+    float slope = 1.f / s.ratio - 1.f;
+    T hard = slope * rack::simd::fmax(over, T(0.f));
+    if (s.knee <= 0.f)
+        return hard;
+    T k = over + 0.5f * s.knee;
+    T soft = slope * k * k * (0.5f / s.knee);
+    return rack::simd::ifelse(2.f * rack::simd::fabs(over) <= T(s.knee), soft, hard);
+}
+
+// État d'un compresseur, T = float ou rack::simd::float_4 (une voie par canal)
+template <typename T>
+struct CompressorState {
+    T ms = 0.f; // Moyenne quadratique du détecteur RMS
+    T gr = 0.f; // Réduction de gain lissée, dB
+
+    void reset() {
+        ms = 0.f;
+        gr = 0.f;
+    }
+
+    // Niveau détecté, en dB
+    T level(const CompressorSettings& s, T x) {
+        if (s.detector == DETECTOR_RMS) {
+            ms += (x * x - ms) * s.rms;
+            // 10 log10(ms) = 20 log10(sqrt(ms)) : la racine est prise dans le log
+            return 0.5f * ampToDb_simd(ms * (1.f / DB_REFERENCE));
+        }
+        return ampToDb_simd(rack::simd::fabs(x));
+    }
+
+    // Gain pour un niveau détecté, en dB
+    T gainFromLevel(const CompressorSettings& s, T level) {
+        T target = compressorGain(s, level);
+        // Attaque quand la réduction augmente, relâchement sinon
+        T coef = rack::simd::ifelse(target < gr, T(s.attack), T(s.release));
+        gr += (target - gr) * coef;
+        return dbToGain_simd(gr + s.makeup);
+    }
+
+    // Gain à appliquer à l'échantillon de détection x (lui-même, ou la chaîne latérale)
+    T gain(const CompressorSettings& s, T x) {
+        return gainFromLevel(s, level(s, x));
+    }
+
+    T process(const CompressorSettings& s, T x) {
+        return x * gain(s, x);
+    }
+};
+
+// === Multibande ===
+
+// Biquad en forme transposée II, coefficients propres à chaque voie
+struct BiquadCoefs {
+    rack::simd::float_4 b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+
+    enum Type {
+        IDENTITY,
+        ZERO,
+        LOWPASS,
+        HIGHPASS,
+        ALLPASS
+    };
+
+    // Butterworth du second ordre (Q = 1/sqrt(2)) de coupure f sur la voie lane
+    void setLane(int lane, Type type, float f, float sampleRate);
+};
+
+struct BiquadState {
+    rack::simd::float_4 z1 = 0.f, z2 = 0.f;
+
+    rack::simd::float_4 process(const BiquadCoefs& k, rack::simd::float_4 x) {
+        rack::simd::float_4 y = k.b0 * x + z1;
+        z1 = k.b1 * x - k.a1 * y + z2;
+        z2 = k.b2 * x - k.a2 * y;
+        return y;
+    }
+};
+
+// Séparation en 3 ou 4 bandes par filtres de Linkwitz-Riley d'ordre 4 (deux
+// Butterworth en cascade), les bandes occupant les voies d'un float_4 :
+// - coupure centrale f2 : voies [bas, haut] ;
+// - bas coupé en f1 et haut en f3 : voies [LP f1, HP f1, LP f3, HP f3]
+//   (à 3 bandes, le haut passe tel quel et la voie 3 reste nulle) ;
+// - chaque branche reçoit le passe-tout de la coupure de l'autre branche, de
+//   sorte que la somme des bandes est un passe-tout : réponse plate.
+struct CrossoverCoefs {
+    static const int MAX_BANDS = 4;
+
+    int bands = MAX_BANDS;
+    BiquadCoefs split, band, allpass;
+
+    void set(int bands, float f1, float f2, float f3, float sampleRate);
+};
+
+struct CrossoverState {
+    BiquadState split[2], band[2], allpass;
+
+    // Bandes de l'échantillon x, une par voie
+    rack::simd::float_4 process(const CrossoverCoefs& k, float x) {
+        rack::simd::float_4 s = split[1].process(k.split, split[0].process(k.split, x));
+        rack::simd::float_4 b(s[0], s[0], s[1], s[1]);
+        b = band[1].process(k.band, band[0].process(k.band, b));
+        return allpass.process(k.allpass, b);
+    }
+
+    void reset() {
+        *this = CrossoverState();
+    }
+};
+
+#endif // COMPRESSION_HPP
@@ -0,0 +1,105 @@
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include <cstdint>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+#include "filtres.hpp"
+#include "rng.hpp"
+
+// === Résonance stochastique en réseau ===
+
+enum Coupling {
+    COUPLING_NONE,   // Unités indépendantes
+    COUPLING_RING,   // Chaque unité tirée vers ses deux voisines
+    COUPLING_GLOBAL, // Chaque unité tirée vers la moyenne du réseau
+    COUPLINGS_LEN
+};
+
+// Réseau d'unités RS recevant le même signal et le même bruit externe, chacune
+// avec son propre bruit interne. Les unités occupent les voies de float_4 et
+// passent par le même rsProcess_simd que le module à une particule.
+// Couplage diffusif : D (x_j - x_i) ajouté à la force de l'unité i, évalué
+// sur l'état au début du pas. La sortie est la moyenne des unités.
+struct RSEnsemble {
+    static const int MAX_UNITS = 64;
+
+    rack::simd::float_4 x[MAX_UNITS / 4];
+    rack::simd::float_4 nonFinite = 0.f; // États non finis remis à -1, par voie
+    GaussianGenerator rng;
+
+    RSEnsemble() {
+        reset(-1.f);
+    }
+
+    void seed(uint64_t seed) {
+        rng.seed(seed);
+    }
+
+    void reset(float x0) {
+        for (int i = 0; i < MAX_UNITS / 4; ++i)
+            x[i] = x0;
+    }
+
+    // Nombre d'états non finis depuis le dernier appel, toutes unités confondues
+    uint64_t takeNonFinite() {
+        float n = nonFinite[0] + nonFinite[1] + nonFinite[2] + nonFinite[3];
+        nonFinite = 0.f;
+        return (uint64_t)n;
+    }
+
+    // units : multiple de 4, au plus MAX_UNITS. sigma : écart type du bruit interne (V).
+    // Coefficients scalaires du canal, diffusés sur les voies ; step : noyau
+    // float_4 de la forme et du nombre de puits (potential_kernel).
+    float process(int filter, PotentialKernel<rack::simd::float_4> step, int units, int coupling, float strength,
+                  float sigma, float si, float ni, float threshold, float h, float g,
+                  const MultiWellCoefs<float>& wells) {
+        using rack::simd::float_4;
+        int groups = units / 4;
+        MultiWellCoefs<float_4> k;
+        k.N = wells.N;
+        k.c = wells.c;
+        k.L = wells.L;
+        k.invL = wells.invL;
+        k.invXb2 = wells.invXb2;
+        k.asymNeg = wells.asymNeg;
+        k.asymPos = wells.asymPos;
+
+        float_4 force[MAX_UNITS / 4];
+        if (coupling == COUPLING_RING && strength != 0.f) {
+            float xs[MAX_UNITS];
+            for (int i = 0; i < groups; ++i)
+                x[i].store(&xs[4 * i]);
+            for (int i = 0; i < groups; ++i) {
+                float_4 left, right;
+                for (int l = 0; l < 4; ++l) {
+                    int j = 4 * i + l;
+                    left[l] = xs[j == 0 ? units - 1 : j - 1];
+                    right[l] = xs[j == units - 1 ? 0 : j + 1];
+                }
+                force[i] = si + strength * (left + right - 2.f * x[i]);
+            }
+        } else if (coupling == COUPLING_GLOBAL && strength != 0.f) {
+            float_4 sum = 0.f;
+            for (int i = 0; i < groups; ++i)
+                sum += x[i];
+            float mean = (sum[0] + sum[1] + sum[2] + sum[3]) / units;
+            for (int i = 0; i < groups; ++i)
+                force[i] = si + strength * (mean - x[i]);
+        } else {
+            for (int i = 0; i < groups; ++i)
+                force[i] = si;
+        }
+
+        float_4 sum = 0.f;
+        for (int i = 0; i < groups; ++i) {
+            float_4 n = ni;
+            if (sigma != 0.f)
+                n += sigma * rng.gaussian4();
+            sum += rsProcess_simd<float_4>(filter, step, x[i], force[i], n, threshold, h, g, k, &nonFinite);
+        }
+        return (sum[0] + sum[1] + sum[2] + sum[3]) / units;
+    }
+};
+
+#endif // ENSEMBLE_HPP
@@ -19,12 +19,6 @@ float bistableFilter(float xi, float si, float ni, float dt, float tau, float Xb
     return xi + dt / tau * (xi - 1.f / (Xb * Xb) * xi * xi * xi + si + ni);
 }
 
-// Filtre multi-puits
-float multiWellFilter(float xi, float si, float ni, float dt, float tau, int N, float Xb) {
-    float dx = si + ni - multi_well_grad(xi, N, Xb);
-    return xi + dt / tau * dx;
-}
-
 // Potentiel bistable
 float bistablePotential(float x, float th) {
     return -0.5f * x * x + (1.f / (4.f * th * th)) * x * x * x * x;
@@ -32,6 +26,24 @@ float bistablePotential(float x, float th) {
 
 // Potentiel multi-puits
 float multi_well_potential(float x, int N, float Xb) {
+#ifdef FILTRES_REFERENCE
+    return multi_well_potential_ref(x, N, Xb);
+#else
+    return multi_well_potential_simd<float>(x, N, Xb);
+#endif
+}
+
+// Gradient du potentiel multi-puits
+float multi_well_grad(float x, int N, float Xb) {
+#ifdef FILTRES_REFERENCE
+    return multi_well_grad_ref(x, N, Xb);
+#else
+    return multi_well_grad_simd<float>(x, N, Xb);
+#endif
+}
+
+// Potentiel multi-puits (référence : balayage linéaire des puits)
+float multi_well_potential_ref(float x, int N, float Xb) {
     float L = 2.0f * Xb;
     std::vector<float> x0_list(N);
     for (int i = 0; i < N; ++i)
@@ -54,8 +66,8 @@ float multi_well_potential(float x, int N, float Xb) {
     return 0.f;
 }
 
-// Gradient du potentiel multi-puits
-float multi_well_grad(float x, int N, float Xb) {
+// Gradient du potentiel multi-puits (référence)
+float multi_well_grad_ref(float x, int N, float Xb) {
     float L = 2.0f * Xb;
     std::vector<float> x0_list(N);
     for (int i = 0; i < N; ++i)
@@ -77,3 +89,20 @@ float multi_well_grad(float x, int N, float Xb) {
     // En dehors de tout puits
     return 0.f;
 }
+
+// Sinus cardinal fenêtré, de gain unité en continu
+void OversamplingFilter::setFactor(int factor) {
+    this->factor = factor;
+    int n = factor * TAPS_PER_PHASE;
+    double fc = 0.5 / factor; // En fraction de la fréquence suréchantillonnée
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double t = i - (n - 1) / 2.0;
+        double sinc = (t == 0.0) ? 2.0 * fc : std::sin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double w = 0.42 - 0.5 * std::cos(2.0 * M_PI * i / (n - 1)) + 0.08 * std::cos(4.0 * M_PI * i / (n - 1));
+        h[i] = (float)(sinc * w);
+        sum += h[i];
+    }
+    for (int i = 0; i < n; ++i)
+        h[i] = (float)(h[i] / sum);
+}
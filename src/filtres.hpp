@@ -2,13 +2,742 @@
 #ifndef FILTRES_HPP
 #define FILTRES_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+#include <vector>
+
 float multi_well_potential(float x, int N, float Xb);
 float multi_well_grad(float x, int N, float Xb) ;
+// Noyaux de référence (balayage des puits), pour comparaison avec les noyaux directs.
+// Avec -DFILTRES_REFERENCE, multi_well_potential et multi_well_grad (courbe
+// affichée) les utilisent ; le chemin audio passe toujours par potential_kernel.
+float multi_well_potential_ref(float x, int N, float Xb);
+float multi_well_grad_ref(float x, int N, float Xb);
 float diode(float x, float th);
 float bistableFilter(float xi, float si, float ni, float dt, float tau, float Xb);
 float bistablePotential(float x, float th);
 float rubber(float x, float th);
-float multiWellFilter(float xi, float si, float ni, float dt,float tau, int N, float Xb);
+
+
+// === Versions vectorielles ===
+// T = float ou rack::simd::float_4 (quatre canaux polyphoniques à la fois).
+// Les seuils et Xb sont par canal, le nombre de puits N est commun.
+
+template <typename T>
+inline T diode_simd(T x, T th) {
+    return rack::simd::ifelse(x >= th, x - th, T(0.f));
+}
+
+template <typename T>
+inline T rubber_simd(T x, T th) {
+    return rack::simd::ifelse(x >= th, x - th, rack::simd::ifelse(x <= -th, x + th, T(0.f)));
+}
+
+// Coefficients du potentiel multi-puits, précalculés hors de la boucle audio
+template <typename T>
+struct MultiWellCoefs {
+    int N = 1;
+    float c = 0.f;  // Indice du centre, (N - 1) / 2
+    T L = 2.f;      // Distance entre puits, 2 Xb
+    T invL = 0.5f;
+    T invXb2 = 1.f; // 1 / Xb²
+    // Facteurs de invXb2 pour x < 0 et x >= 0 (bistable asymétrique)
+    T asymNeg = 1.f, asymPos = 1.f;
+
+    MultiWellCoefs() {}
+    MultiWellCoefs(int N, T Xb) {
+        set(N, Xb);
+    }
+
+    void set(int N, T Xb) {
+        this->N = N;
+        c = (N - 1) / 2.0f;
+        L = 2.0f * Xb;
+        invL = 1.f / L;
+        invXb2 = 1.f / (Xb * Xb);
+    }
+
+    // Puits de droite à Xb (1 + a), de gauche à Xb (1 - a), |a| < 1
+    void setAsymmetry(float a) {
+        asymNeg = 1.f / ((1.f - a) * (1.f - a));
+        asymPos = 1.f / ((1.f + a) * (1.f + a));
+    }
+};
+
+// Indice du puits actif (0 à N - 1), et écart à son centre.
+// Le puits i couvre [x0_i - Xb, x0_i + Xb] avec x0_i = (i - (N - 1) / 2) * 2Xb :
+// son indice se déduit directement de x, sans parcourir la liste des puits.
+// Une frontière commune appartient au puits de gauche, comme dans la référence.
+template <typename T>
+inline T well_index_simd(T x, const MultiWellCoefs<T>& k) {
+    T i = -rack::simd::floor(0.5f - k.c - x * k.invL); // ceil(x / L + c - 0.5)
+    return rack::simd::fmin(rack::simd::fmax(i, T(0.f)), T((float)(k.N - 1)));
+}
+
+template <typename T>
+inline T well_offset_simd(T x, const MultiWellCoefs<T>& k) {
+    return x - (well_index_simd(x, k) - k.c) * k.L;
+}
+
+template <typename T>
+inline T multi_well_potential_simd(T x, const MultiWellCoefs<T>& k) {
+    T dx = well_offset_simd(x, k);
+    T dx2 = dx * dx;
+    return dx2 * (-0.5f + 0.25f * k.invXb2 * dx2);
+}
+
+template <typename T>
+inline T multi_well_grad_simd(T x, const MultiWellCoefs<T>& k) {
+    T dx = well_offset_simd(x, k);
+    return dx * (k.invXb2 * dx * dx - 1.f);
+}
+
+// Courbure du potentiel au point x (dérivée du gradient) : 3 dx² / Xb² - 1
+template <typename T>
+inline T multi_well_curvature_simd(T x, const MultiWellCoefs<T>& k) {
+    T dx = well_offset_simd(x, k);
+    return 3.f * k.invXb2 * dx * dx - 1.f;
+}
+
+template <typename T>
+inline T multi_well_potential_simd(T x, int N, T Xb) {
+    if (N < 1) return T(0.f);
+    return multi_well_potential_simd(x, MultiWellCoefs<T>(N, Xb));
+}
+
+template <typename T>
+inline T multi_well_grad_simd(T x, int N, T Xb) {
+    if (N < 1) return T(0.f);
+    return multi_well_grad_simd(x, MultiWellCoefs<T>(N, Xb));
+}
+
+// === Intégrateurs du filtre multi-puits ===
+
+enum Integrator {
+    INTEGRATOR_EULER,         // Euler explicite, un pas par échantillon
+    INTEGRATOR_HEUN,          // Heun, sous-pas adaptatifs
+    INTEGRATOR_RK4,           // Runge-Kutta 4, sous-pas adaptatifs
+    INTEGRATOR_SEMI_IMPLICIT, // Euler semi-implicite, stable pour tout pas
+    INTEGRATORS_LEN
+};
+
+// Pas de référence (44.1 kHz) pour la mise à l'échelle du bruit
+static const float MULTI_WELL_REF_DT = 1.f / 44100.f;
+// Pas réduit maximal dt / tau * |courbure| toléré par un sous-pas explicite
+static const float MULTI_WELL_MAX_STEP = 0.5f;
+static const int MULTI_WELL_MAX_SUBSTEPS = 32;
+
+inline float hmax_simd(float x) {
+    return x;
+}
+
+inline float hmax_simd(rack::simd::float_4 x) {
+    return std::fmax(std::fmax(x[0], x[1]), std::fmax(x[2], x[3]));
+}
+
+// Gain du bruit sur un pas d'échantillon (voir multiWellStep_simd)
+template <typename T>
+inline T multi_well_noise_gain(float dt, T tau) {
+    return std::sqrt(dt * MULTI_WELL_REF_DT) / tau;
+}
+
+// === Potentiels ===
+// Chaque forme est une politique : gradient, courbure (pour les intégrateurs
+// adaptatifs et semi-implicite), valeur (pour l'affichage) et indice du puits
+// contenant x, connus à la compilation. Le pas d'intégration est instancié
+// pour chaque forme, chaque nombre de puits et chaque intégrateur ; le noyau
+// est choisi dans une table une fois par tick de contrôle, et la boucle
+// interne ne teste plus rien.
+
+enum PotentialShape {
+    POTENTIAL_MULTI_WELL, // N puits quartiques
+    POTENTIAL_ASYMMETRIC, // Bistable aux puits de largeurs et profondeurs différentes
+    POTENTIAL_TRISTABLE,  // Puits en 0 et ±Xb
+    POTENTIAL_WASHBOARD,  // Périodique, puits tous les 2 Xb
+    POTENTIAL_SHAPES_LEN
+};
+
+static const int MULTI_WELL_MAX_N = 16;
+
+// N puits quartiques ; avec N fixé, le centre et la borne de l'indice sont
+// des constantes
+template <int N>
+struct MultiWellPotential {
+    static const int WELLS = N;
+    static constexpr float C = (N - 1) / 2.f; // Indice du centre
+
+    template <typename T>
+    static T index(T x, const MultiWellCoefs<T>& k) {
+        T i = -rack::simd::floor(0.5f - C - x * k.invL);
+        return rack::simd::fmin(rack::simd::fmax(i, T(0.f)), T((float)(N - 1)));
+    }
+
+    template <typename T>
+    static T offset(T x, const MultiWellCoefs<T>& k) {
+        return x - (index(x, k) - C) * k.L;
+    }
+
+    template <typename T>
+    static T grad(T x, const MultiWellCoefs<T>& k) {
+        T dx = offset(x, k);
+        return dx * (k.invXb2 * dx * dx - 1.f);
+    }
+
+    template <typename T>
+    static T curvature(T x, const MultiWellCoefs<T>& k) {
+        T dx = offset(x, k);
+        return 3.f * k.invXb2 * dx * dx - 1.f;
+    }
+
+    template <typename T>
+    static T potential(T x, const MultiWellCoefs<T>& k) {
+        T dx = offset(x, k);
+        T dx2 = dx * dx;
+        return dx2 * (-0.5f + 0.25f * k.invXb2 * dx2);
+    }
+};
+
+template <int N>
+constexpr float MultiWellPotential<N>::C;
+
+// Un seul puits : pas d'indice à calculer
+template <>
+template <typename T>
+T MultiWellPotential<1>::offset(T x, const MultiWellCoefs<T>&) {
+    return x;
+}
+
+// Bistable quartique dont chaque moitié a sa propre largeur : le puits de
+// gauche est en -Xb (1 - a), celui de droite en Xb (1 + a), et la barrière
+// reste en 0. Contrairement à une inclinaison, ce n'est pas un décalage du signal.
+struct AsymmetricPotential {
+    static const int WELLS = 2;
+
+    template <typename T>
+    static T scale(T x, const MultiWellCoefs<T>& k) {
+        return k.invXb2 * rack::simd::ifelse(x < 0.f, k.asymNeg, k.asymPos);
+    }
+
+    template <typename T>
+    static T index(T x, const MultiWellCoefs<T>&) {
+        return rack::simd::ifelse(x < 0.f, T(0.f), T(1.f));
+    }
+
+    template <typename T>
+    static T grad(T x, const MultiWellCoefs<T>& k) {
+        return x * (scale(x, k) * x * x - 1.f);
+    }
+
+    template <typename T>
+    static T curvature(T x, const MultiWellCoefs<T>& k) {
+        return 3.f * scale(x, k) * x * x - 1.f;
+    }
+
+    template <typename T>
+    static T potential(T x, const MultiWellCoefs<T>& k) {
+        T x2 = x * x;
+        return x2 * (-0.5f + 0.25f * scale(x, k) * x2);
+    }
+};
+
+// Tristable : U'(x) = 4 x (u - 1/4)(u - 1) avec u = x² / Xb², puits en 0 et
+// ±Xb, barrières en ±Xb / 2, courbure unité au fond du puits central
+struct TristablePotential {
+    static const int WELLS = 3;
+
+    template <typename T>
+    static T index(T x, const MultiWellCoefs<T>& k) {
+        T u = x * x * k.invXb2;
+        return rack::simd::ifelse(u <= 0.25f, T(1.f), rack::simd::ifelse(x < 0.f, T(0.f), T(2.f)));
+    }
+
+    template <typename T>
+    static T grad(T x, const MultiWellCoefs<T>& k) {
+        T u = x * x * k.invXb2;
+        return 4.f * x * (u - 0.25f) * (u - 1.f);
+    }
+
+    template <typename T>
+    static T curvature(T x, const MultiWellCoefs<T>& k) {
+        T u = x * x * k.invXb2;
+        return (20.f * u - 15.f) * u + 1.f;
+    }
+
+    template <typename T>
+    static T potential(T x, const MultiWellCoefs<T>& k) {
+        T u = x * x * k.invXb2;
+        return ((2.f / 3.f * u - 1.25f) * u + 0.5f) * u / k.invXb2;
+    }
+};
+
+// Planche à laver : U(x) = -(Xb² / 8) cos(π x / Xb), puits tous les 2 Xb, de
+// même barrière Xb² / 4 que le quartique. Indice centré sur le puits en 0.
+struct WashboardPotential {
+    static const int WELLS = MULTI_WELL_MAX_N;
+
+    template <typename T>
+    static T index(T x, const MultiWellCoefs<T>& k) {
+        T i = rack::simd::floor(x * k.invL + 0.5f) + (float)(WELLS / 2);
+        return rack::simd::fmin(rack::simd::fmax(i, T(0.f)), T((float)(WELLS - 1)));
+    }
+
+    template <typename T>
+    static T grad(T x, const MultiWellCoefs<T>& k) {
+        return (float)(M_PI / 16.0) * k.L * rack::simd::sin((float)(2.0 * M_PI) * x * k.invL);
+    }
+
+    template <typename T>
+    static T curvature(T x, const MultiWellCoefs<T>& k) {
+        return (float)(M_PI * M_PI / 8.0) * rack::simd::cos((float)(2.0 * M_PI) * x * k.invL);
+    }
+
+    template <typename T>
+    static T potential(T x, const MultiWellCoefs<T>& k) {
+        return -(1.f / 32.f) * k.L * k.L * rack::simd::cos((float)(2.0 * M_PI) * x * k.invL);
+    }
+};
+
+// Un pas d'échantillon dx = (s - U'(x)) h + n g, avec h = dt / tau et
+// g = sqrt(dt dt_ref) / tau.
+// Le bruit suit Euler-Maruyama : sa variance croît comme dt, et le pas de
+// référence rend le résultat identique à l'ancien schéma à 44.1 kHz, tout
+// en gardant la même dynamique à 192 kHz. Le signal est tenu sur le pas.
+template <typename P, int METHOD, typename T>
+inline T potentialStep_simd(T xi, T si, T ni, T h, T g, const MultiWellCoefs<T>& k) {
+    T w = ni * g;
+
+    if (METHOD == INTEGRATOR_SEMI_IMPLICIT) {
+        // Partie raide (courbure positive) traitée implicitement
+        T curv = rack::simd::fmax(P::curvature(xi, k), T(0.f));
+        return xi + (h * (si - P::grad(xi, k)) + w) / (1.f + h * curv);
+    }
+    if (METHOD != INTEGRATOR_HEUN && METHOD != INTEGRATOR_RK4) {
+        return xi + h * (si - P::grad(xi, k)) + w;
+    }
+
+    // Nombre de sous-pas choisi d'après la raideur locale (canal le plus raide)
+    float stiffness = hmax_simd(h * rack::simd::fabs(P::curvature(xi, k)));
+    int M = (int)std::ceil(stiffness / MULTI_WELL_MAX_STEP);
+    M = std::min(std::max(M, 1), MULTI_WELL_MAX_SUBSTEPS);
+    T hs = h / (float)M;
+    T ws = w / (float)M;
+
+    T x = xi;
+    if (METHOD == INTEGRATOR_HEUN) {
+        for (int m = 0; m < M; ++m) {
+            T k1 = si - P::grad(x, k);
+            T k2 = si - P::grad(x + hs * k1 + ws, k);
+            x += 0.5f * hs * (k1 + k2) + ws;
+        }
+    } else {
+        for (int m = 0; m < M; ++m) {
+            T k1 = si - P::grad(x, k);
+            T k2 = si - P::grad(x + 0.5f * hs * k1, k);
+            T k3 = si - P::grad(x + 0.5f * hs * k2, k);
+            T k4 = si - P::grad(x + hs * k3, k);
+            x += hs / 6.f * (k1 + 2.f * k2 + 2.f * k3 + k4) + ws;
+        }
+    }
+    return x;
+}
+
+// Intégrateur choisi à l'exécution, pour une politique hors table
+template <typename P, typename T>
+inline T potentialStep_simd(int method, T xi, T si, T ni, T h, T g, const MultiWellCoefs<T>& k) {
+    switch (method) {
+        case INTEGRATOR_HEUN: return potentialStep_simd<P, INTEGRATOR_HEUN>(xi, si, ni, h, g, k);
+        case INTEGRATOR_RK4: return potentialStep_simd<P, INTEGRATOR_RK4>(xi, si, ni, h, g, k);
+        case INTEGRATOR_SEMI_IMPLICIT: return potentialStep_simd<P, INTEGRATOR_SEMI_IMPLICIT>(xi, si, ni, h, g, k);
+        default: return potentialStep_simd<P, INTEGRATOR_EULER>(xi, si, ni, h, g, k);
+    }
+}
+
+template <typename T>
+using PotentialKernel = T (*)(T xi, T si, T ni, T h, T g, const MultiWellCoefs<T>& k);
+template <typename T>
+using PotentialIndex = T (*)(T x, const MultiWellCoefs<T>& k);
+
+// Tables des noyaux instanciés, indexées par forme, N - 1 et intégrateur.
+// Les formes à nombre de puits fixe répètent la même ligne pour chaque N.
+#define POTENTIAL_STEPS(P) { \
+    &potentialStep_simd<P, INTEGRATOR_EULER, T>, &potentialStep_simd<P, INTEGRATOR_HEUN, T>, \
+    &potentialStep_simd<P, INTEGRATOR_RK4, T>, &potentialStep_simd<P, INTEGRATOR_SEMI_IMPLICIT, T>}
+#define POTENTIAL_STEPS_16(P) { \
+    POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), \
+    POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), \
+    POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), \
+    POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P), POTENTIAL_STEPS(P)}
+#define POTENTIAL_INDEX_16(P) { \
+    &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, \
+    &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>, &P::index<T>}
+
+template <typename T>
+struct PotentialKernels {
+    static constexpr PotentialKernel<T> steps[POTENTIAL_SHAPES_LEN][MULTI_WELL_MAX_N][INTEGRATORS_LEN] = {
+        {
+            POTENTIAL_STEPS(MultiWellPotential<1>), POTENTIAL_STEPS(MultiWellPotential<2>),
+            POTENTIAL_STEPS(MultiWellPotential<3>), POTENTIAL_STEPS(MultiWellPotential<4>),
+            POTENTIAL_STEPS(MultiWellPotential<5>), POTENTIAL_STEPS(MultiWellPotential<6>),
+            POTENTIAL_STEPS(MultiWellPotential<7>), POTENTIAL_STEPS(MultiWellPotential<8>),
+            POTENTIAL_STEPS(MultiWellPotential<9>), POTENTIAL_STEPS(MultiWellPotential<10>),
+            POTENTIAL_STEPS(MultiWellPotential<11>), POTENTIAL_STEPS(MultiWellPotential<12>),
+            POTENTIAL_STEPS(MultiWellPotential<13>), POTENTIAL_STEPS(MultiWellPotential<14>),
+            POTENTIAL_STEPS(MultiWellPotential<15>), POTENTIAL_STEPS(MultiWellPotential<16>),
+        },
+        POTENTIAL_STEPS_16(AsymmetricPotential),
+        POTENTIAL_STEPS_16(TristablePotential),
+        POTENTIAL_STEPS_16(WashboardPotential),
+    };
+
+    static constexpr PotentialIndex<T> indices[POTENTIAL_SHAPES_LEN][MULTI_WELL_MAX_N] = {
+        {
+            &MultiWellPotential<1>::template index<T>, &MultiWellPotential<2>::template index<T>,
+            &MultiWellPotential<3>::template index<T>, &MultiWellPotential<4>::template index<T>,
+            &MultiWellPotential<5>::template index<T>, &MultiWellPotential<6>::template index<T>,
+            &MultiWellPotential<7>::template index<T>, &MultiWellPotential<8>::template index<T>,
+            &MultiWellPotential<9>::template index<T>, &MultiWellPotential<10>::template index<T>,
+            &MultiWellPotential<11>::template index<T>, &MultiWellPotential<12>::template index<T>,
+            &MultiWellPotential<13>::template index<T>, &MultiWellPotential<14>::template index<T>,
+            &MultiWellPotential<15>::template index<T>, &MultiWellPotential<16>::template index<T>,
+        },
+        POTENTIAL_INDEX_16(AsymmetricPotential),
+        POTENTIAL_INDEX_16(TristablePotential),
+        POTENTIAL_INDEX_16(WashboardPotential),
+    };
+};
+
+#undef POTENTIAL_STEPS
+#undef POTENTIAL_STEPS_16
+#undef POTENTIAL_INDEX_16
+
+template <typename T>
+constexpr PotentialKernel<T> PotentialKernels<T>::steps[POTENTIAL_SHAPES_LEN][MULTI_WELL_MAX_N][INTEGRATORS_LEN];
+template <typename T>
+constexpr PotentialIndex<T> PotentialKernels<T>::indices[POTENTIAL_SHAPES_LEN][MULTI_WELL_MAX_N];
+
+// Noyau d'un pas pour la forme, le nombre de puits et l'intégrateur, à
+// choisir hors de la boucle audio (une fois par tick de contrôle)
+template <typename T>
+inline PotentialKernel<T> potential_kernel(int shape, int N, int method) {
+    shape = std::min(std::max(shape, 0), (int)POTENTIAL_SHAPES_LEN - 1);
+    N = std::min(std::max(N, 1), MULTI_WELL_MAX_N);
+    method = std::min(std::max(method, 0), (int)INTEGRATORS_LEN - 1);
+    return PotentialKernels<T>::steps[shape][N - 1][method];
+}
+
+// Indice du puits contenant x pour la forme et le nombre de puits
+template <typename T>
+inline PotentialIndex<T> potential_index_kernel(int shape, int N) {
+    shape = std::min(std::max(shape, 0), (int)POTENTIAL_SHAPES_LEN - 1);
+    N = std::min(std::max(N, 1), MULTI_WELL_MAX_N);
+    return PotentialKernels<T>::indices[shape][N - 1];
+}
+
+template <typename T>
+inline T multiWellStep_simd(int method, T xi, T si, T ni, T h, T g, const MultiWellCoefs<T>& k) {
+    return potential_kernel<T>(POTENTIAL_MULTI_WELL, k.N, method)(xi, si, ni, h, g, k);
+}
+
+// Pas du filtre pour la forme de potentiel choisie
+template <typename T>
+inline T potentialStepDispatch_simd(int shape, int method, T xi, T si, T ni, T h, T g, const MultiWellCoefs<T>& k) {
+    return potential_kernel<T>(shape, k.N, method)(xi, si, ni, h, g, k);
+}
+
+// Indice du puits contenant x, de 0 à potential_wells(shape, N) - 1
+template <typename T>
+inline T potential_index_simd(int shape, T x, const MultiWellCoefs<T>& k) {
+    return potential_index_kernel<T>(shape, k.N)(x, k);
+}
+
+inline int potential_wells(int shape, int N) {
+    switch (shape) {
+        case POTENTIAL_ASYMMETRIC: return AsymmetricPotential::WELLS;
+        case POTENTIAL_TRISTABLE: return TristablePotential::WELLS;
+        case POTENTIAL_WASHBOARD: return WashboardPotential::WELLS;
+        default: return N;
+    }
+}
+
+// Valeur du potentiel, pour l'affichage
+template <typename T>
+inline T potential_simd(int shape, T x, const MultiWellCoefs<T>& k) {
+    switch (shape) {
+        case POTENTIAL_ASYMMETRIC: return AsymmetricPotential::potential(x, k);
+        case POTENTIAL_TRISTABLE: return TristablePotential::potential(x, k);
+        case POTENTIAL_WASHBOARD: return WashboardPotential::potential(x, k);
+        default: return multi_well_potential_simd(x, k);
+    }
+}
+
+template <typename T>
+inline T multiWellStep_simd(int method, T xi, T si, T ni, float dt, T tau, int N, T Xb) {
+    if (N < 1) N = 1;
+    return multiWellStep_simd(method, xi, si, ni, dt / tau, multi_well_noise_gain(dt, tau), MultiWellCoefs<T>(N, Xb));
+}
+
+// === Échantillon complet du module RS ===
+
+enum FilterType {
+    FILTER_NONE,
+    FILTER_DIODE,
+    FILTER_RUBBER,
+    FILTER_MULTI_WELL
+};
+
+// Filtre choisi puis limite ±5 V. L'état xi n'évolue que pour le filtre
+// multi-puits (noyau step, voir potential_kernel), et il reprend la valeur limitée.
+// La limite rendrait fini un NaN : une valeur non finie est comptée avant elle
+// dans *nonFinite (si fourni), et l'état repart alors de -1 comme au départ.
+template <typename T>
+inline T rsProcess_simd(int filter, PotentialKernel<T> step, T& xi, T si, T ni, T threshold, T h, T g,
+                        const MultiWellCoefs<T>& k, T* nonFinite = nullptr) {
+    T out = 0.f;
+    if (filter == FILTER_DIODE) {
+        out = diode_simd(si + ni, threshold);
+    } else if (filter == FILTER_RUBBER) {
+        out = rubber_simd(si + ni, threshold);
+    } else if (filter == FILTER_MULTI_WELL) {
+        out = step(xi, si, ni, h, g, k);
+    }
+    T finite = rack::simd::fabs(out) < T(INFINITY);
+    if (nonFinite)
+        *nonFinite += rack::simd::ifelse(finite, T(0.f), T(1.f));
+    out = rack::simd::fmin(rack::simd::fmax(out, T(-5.f)), T(5.f));
+    if (filter == FILTER_MULTI_WELL) {
+        out = rack::simd::ifelse(finite, out, T(-1.f));
+        xi = out;
+    }
+    return out;
+}
+
+// Même chose, noyau cherché à chaque appel (essais, outils hors temps réel)
+template <typename T>
+inline T rsProcess_simd(int filter, int method, T& xi, T si, T ni, T threshold, T h, T g, const MultiWellCoefs<T>& k,
+                        int shape = POTENTIAL_MULTI_WELL, T* nonFinite = nullptr) {
+    return rsProcess_simd<T>(filter, potential_kernel<T>(shape, k.N, method), xi, si, ni, threshold, h, g, k,
+        nonFinite);
+}
+
+// === Anti-repliement des filtres à seuil ===
+// diode et rubber ont un coude franc : appliqués à la fréquence d'échantillonnage,
+// ils replient les harmoniques des signaux audio.
+
+enum Antialiasing {
+    ANTIALIASING_NONE,
+    ANTIALIASING_ADAA1, // Primitive première, retard d'un demi-échantillon
+    ANTIALIASING_ADAA2, // Primitive seconde, retard d'un échantillon
+    ANTIALIASING_OVERSAMPLE2, // Suréchantillonnage polyphase, référence
+    ANTIALIASING_OVERSAMPLE4,
+    ANTIALIASING_MODES_LEN
+};
+
+template <typename T>
+inline T threshold_shape_simd(int filter, T x, T th) {
+    return (filter == FILTER_RUBBER) ? rubber_simd(x, th) : diode_simd(x, th);
+}
+
+// Primitive de diode ou rubber : d²/2, avec d l'excès au-delà du seuil
+template <typename T>
+inline T threshold_ad1_simd(int filter, T x, T th) {
+    T d = rack::simd::fmax(((filter == FILTER_RUBBER) ? rack::simd::fabs(x) : x) - th, T(0.f));
+    return 0.5f * d * d;
+}
+
+// Primitive seconde : d³/6, impaire pour rubber
+template <typename T>
+inline T threshold_ad2_simd(int filter, T x, T th) {
+    T d = rack::simd::fmax(((filter == FILTER_RUBBER) ? rack::simd::fabs(x) : x) - th, T(0.f));
+    T v = (1.f / 6.f) * d * d * d;
+    return (filter == FILTER_RUBBER) ? rack::simd::ifelse(x < 0.f, -v, v) : v;
+}
+
+// Segment linéaire de la non-linéarité contenant x : -1, 0 (zone morte) ou 1
+template <typename T>
+inline T threshold_region_simd(int filter, T x, T th) {
+    T r = rack::simd::ifelse(x >= th, T(1.f), T(0.f));
+    return (filter == FILTER_RUBBER) ? rack::simd::ifelse(x <= -th, T(-1.f), r) : r;
+}
+
+// Anti-repliement par primitives (ADAA) : la non-linéarité est moyennée sur
+// l'intervalle entre échantillons. Quand cet intervalle est trop court pour
+// la division, on revient à la fonction (ou à la primitive) au point milieu.
+// Sur un seul segment linéaire la moyenne est exacte : f au barycentre des
+// points. Les différences de primitives, qui perdent toute précision en float
+// pour un signal lent et ample, ne servent qu'aux passages du seuil.
+template <typename T>
+struct ThresholdAdaa {
+    static constexpr float TOLERANCE = 1e-3f; // V
+
+    T x1 = 0.f, x2 = 0.f; // Entrées précédentes
+
+    void reset() {
+        x1 = x2 = 0.f;
+    }
+
+    T process1(int filter, T x, T th) {
+        T dx = x - x1;
+        T r = threshold_region_simd(filter, x, th);
+        T r1 = threshold_region_simd(filter, x1, th);
+        T linear = (r == r1) | (rack::simd::fabs(dx) < TOLERANCE);
+        T y = (threshold_ad1_simd(filter, x, th) - threshold_ad1_simd(filter, x1, th)) / rack::simd::ifelse(linear, T(1.f), dx);
+        y = rack::simd::ifelse(linear, threshold_shape_simd(filter, 0.5f * (x + x1), th), y);
+        x2 = x1;
+        x1 = x;
+        return y;
+    }
+
+    T process2(int filter, T x, T th) {
+        T dx = x - x2;
+        T ill = rack::simd::fabs(dx) < TOLERANCE;
+        T y = 2.f * (divided(filter, x, x1, th) - divided(filter, x1, x2, th)) / rack::simd::ifelse(ill, T(1.f), dx);
+
+        // x et x2 confondus : développement autour de leur milieu
+        T mid = 0.5f * (x + x2);
+        T delta = mid - x1;
+        T illDelta = rack::simd::fabs(delta) < TOLERANCE;
+        T safe = rack::simd::ifelse(illDelta, T(1.f), delta);
+        T near = 2.f / safe * (threshold_ad1_simd(filter, mid, th)
+            + (threshold_ad2_simd(filter, x1, th) - threshold_ad2_simd(filter, mid, th)) / safe);
+        near = rack::simd::ifelse(illDelta, threshold_shape_simd(filter, 0.5f * (mid + x1), th), near);
+
+        y = rack::simd::ifelse(ill, near, y);
+
+        T r = threshold_region_simd(filter, x, th);
+        T linear = (r == threshold_region_simd(filter, x1, th)) & (r == threshold_region_simd(filter, x2, th));
+        y = rack::simd::ifelse(linear, threshold_shape_simd(filter, (1.f / 3.f) * (x + x1 + x2), th), y);
+        x2 = x1;
+        x1 = x;
+        return y;
+    }
+
+private:
+    // Différence divisée de la primitive seconde entre a et b
+    static T divided(int filter, T a, T b, T th) {
+        T d = a - b;
+        T ill = rack::simd::fabs(d) < TOLERANCE;
+        T y = (threshold_ad2_simd(filter, a, th) - threshold_ad2_simd(filter, b, th)) / rack::simd::ifelse(ill, T(1.f), d);
+        return rack::simd::ifelse(ill, threshold_ad1_simd(filter, 0.5f * (a + b), th), y);
+    }
+};
+
+// Passe-bas de suréchantillonnage : sinus cardinal fenêtré (Blackman) coupé à
+// la moitié de la fréquence d'échantillonnage d'origine, TAPS_PER_PHASE
+// coefficients par phase.
+struct OversamplingFilter {
+    static const int MAX_FACTOR = 4;
+    static const int TAPS_PER_PHASE = 32;
+
+    int factor = 0;
+    float h[MAX_FACTOR * TAPS_PER_PHASE];
+
+    void setFactor(int factor);
+};
+
+// Suréchantillonnage polyphase de la non-linéarité à seuil : interpolation,
+// filtre appliqué à chaque échantillon suréchantillonné, puis décimation.
+template <typename T>
+struct ThresholdOversampler {
+    T in[OversamplingFilter::TAPS_PER_PHASE];
+    T up[OversamplingFilter::MAX_FACTOR * OversamplingFilter::TAPS_PER_PHASE];
+
+    ThresholdOversampler() {
+        reset();
+    }
+
+    void reset() {
+        for (T& v : in) v = 0.f;
+        for (T& v : up) v = 0.f;
+    }
+
+    T process(const OversamplingFilter& k, int filter, T x, T th) {
+        const int K = OversamplingFilter::TAPS_PER_PHASE;
+        const int L = k.factor;
+        for (int i = K - 1; i > 0; --i)
+            in[i] = in[i - 1];
+        in[0] = x;
+
+        const int n = L * K;
+        for (int i = n - 1; i >= L; --i)
+            up[i] = up[i - L];
+        // Phase p : up[L - 1 - p], la plus récente en tête
+        for (int p = 0; p < L; ++p) {
+            T u = 0.f;
+            for (int j = 0; j < K; ++j)
+                u += k.h[j * L + p] * in[j];
+            up[L - 1 - p] = threshold_shape_simd(filter, (float)L * u, th);
+        }
+
+        T y = 0.f;
+        for (int i = 0; i < n; ++i)
+            y += k.h[i] * up[i];
+        return y;
+    }
+};
+
+// === Rétroaction retardée ===
+
+// Ligne à retard de la sortie du filtre, pour la rétroaction s + K x(t - T).
+// L'état varie lentement devant l'échantillon : la ligne est tenue à environ
+// LINE_RATE Hz quelle que soit la fréquence d'échantillonnage, chaque case
+// recevant la moyenne des échantillons de sa période (le bruit de la particule
+// au-dessus de LINE_RATE / 2 ne se replie pas dans la rétroaction), et lue avec
+// interpolation linéaire. Elle ne contient que MAX_DELAY secondes.
+template <typename T>
+struct DelayLine {
+    static constexpr float MAX_DELAY = 1.f;      // s
+    static constexpr float LINE_RATE = 6000.f;   // Hz
+
+    std::vector<T> buffer;
+    int decimation = 1; // Échantillons par case de la ligne
+    float lineRate = LINE_RATE;
+    int write = 0;      // Dernière case écrite
+    int phase = 0;      // Échantillons depuis cette écriture
+    T sum = 0.f;        // Somme de ces échantillons
+
+    // Seul endroit où la ligne est allouée
+    void setSampleRate(float sampleRate) {
+        decimation = std::max(1, (int)std::round(sampleRate / LINE_RATE));
+        lineRate = sampleRate / decimation;
+        buffer.assign((int)std::ceil(MAX_DELAY * lineRate) + 2, T(0.f));
+        write = 0;
+        phase = 0;
+        sum = 0.f;
+    }
+
+    void reset(T x) {
+        std::fill(buffer.begin(), buffer.end(), x);
+        phase = 0;
+        sum = 0.f;
+    }
+
+    void push(T x) {
+        sum += x;
+        if (++phase < decimation)
+            return;
+        if (++write == (int)buffer.size())
+            write = 0;
+        buffer[write] = sum * (1.f / decimation);
+        phase = 0;
+        sum = 0.f;
+    }
+
+    // Valeur d'il y a delay secondes (au moins la dernière case écrite). Une
+    // case vaut l'état au milieu de sa période, (decimation - 1) / 2
+    // échantillons avant son écriture.
+    T read(float delay) const {
+        int size = (int)buffer.size();
+        float pos = delay * lineRate - (phase + 0.5f * (decimation - 1)) / decimation;
+        pos = std::min(std::max(pos, 0.f), (float)(size - 2));
+        int i = (int)pos;
+        float frac = pos - i;
+        int a = write - i;
+        if (a < 0) a += size;
+        int b = (a == 0) ? size - 1 : a - 1;
+        return buffer[a] + (buffer[b] - buffer[a]) * frac;
+    }
+};
 
 #endif // FILTRES_HPP
-      
\ No newline at end of file
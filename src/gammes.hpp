@@ -0,0 +1,75 @@
+#ifndef GAMMES_HPP
+#define GAMMES_HPP
+
+// === Gammes de la sortie V/oct ===
+
+enum Scale {
+    SCALE_MAJOR,
+    SCALE_MINOR,
+    SCALE_DORIAN,
+    SCALE_PHRYGIAN,
+    SCALE_LYDIAN,
+    SCALE_MIXOLYDIAN,
+    SCALE_HARMONIC_MINOR,
+    SCALE_PENTATONIC_MAJOR,
+    SCALE_PENTATONIC_MINOR,
+    SCALE_WHOLE_TONE,
+    SCALE_CHROMATIC,
+    SCALES_LEN
+};
+
+struct ScaleDef {
+    const char* name;
+    int size;         // Degrés par octave
+    int degrees[12];  // Demi-tons au-dessus de la tonique
+};
+
+static const ScaleDef SCALES[SCALES_LEN] = {
+    {"Major", 7, {0, 2, 4, 5, 7, 9, 11}},
+    {"Natural minor", 7, {0, 2, 3, 5, 7, 8, 10}},
+    {"Dorian", 7, {0, 2, 3, 5, 7, 9, 10}},
+    {"Phrygian", 7, {0, 1, 3, 5, 7, 8, 10}},
+    {"Lydian", 7, {0, 2, 4, 6, 7, 9, 11}},
+    {"Mixolydian", 7, {0, 2, 4, 5, 7, 9, 10}},
+    {"Harmonic minor", 7, {0, 2, 3, 5, 7, 8, 11}},
+    {"Major pentatonic", 5, {0, 2, 4, 7, 9}},
+    {"Minor pentatonic", 5, {0, 3, 5, 7, 10}},
+    {"Whole tone", 6, {0, 2, 4, 6, 8, 10}},
+    {"Chromatic", 12, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}},
+};
+
+static const char* const NOTE_NAMES[12] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+// Tension d'un demi-ton : 1 V/oct, ou 5/12 V comme avant le choix de gamme
+// (conservé pour les patchs enregistrés avec cette échelle)
+static const float SEMITONE_VOLTS = 1.f / 12.f;
+static const float LEGACY_SEMITONE_VOLTS = 5.f / 12.f;
+
+// Tension de chaque puits, précalculée : le puits i reçoit le i-ième degré de
+// la gamme en montant depuis la tonique de l'octave 4 (C4 = 0 V).
+struct WellNotes {
+    static const int MAX_WELLS = 16;
+
+    float volts[MAX_WELLS];
+    int scale = -1, root = -1;  // Réglages de la table courante
+    float semitoneVolts = 0.f;
+
+    void set(int scale, int root, float semitoneVolts = SEMITONE_VOLTS) {
+        this->scale = scale;
+        this->root = root;
+        this->semitoneVolts = semitoneVolts;
+        const ScaleDef& s = SCALES[scale];
+        for (int i = 0; i < MAX_WELLS; ++i) {
+            int semitones = root + 12 * (i / s.size) + s.degrees[i % s.size];
+            volts[i] = semitones * semitoneVolts;
+        }
+    }
+
+    // Recalcul seulement si un réglage a changé
+    void update(int scale, int root, float semitoneVolts = SEMITONE_VOLTS) {
+        if (scale != this->scale || root != this->root || semitoneVolts != this->semitoneVolts)
+            set(scale, root, semitoneVolts);
+    }
+};
+
+#endif // GAMMES_HPP
@@ -0,0 +1,70 @@
+#ifndef MESURES_HPP
+#define MESURES_HPP
+
+#include <cmath>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+
+// Mesure incrémentale du rapport signal/bruit (SNR) et de l'amplification
+// spectrale (SPA) d'une sortie y par rapport au signal d'entrée s, sans FFT.
+// Démodulation synchrone : y est projetée sur s et sur sa dérivée (quadrature,
+// qui capte le retard du système), avec des moyennes exponentielles.
+// La différence arrière n'est pas orthogonale à s (E[s d] = var - R(1)) : sa
+// part colinéaire à s est retirée (Gram-Schmidt) avant de sommer les deux
+// projections, sans quoi le recouvrement serait compté deux fois.
+// T = float ou rack::simd::float_4.
+template <typename T>
+struct SnrMeter {
+    T ms = 0.f, my = 0.f;           // Composantes continues
+    T ss = 0.f, dd = 0.f, yy = 0.f; // Puissances de s, de sa dérivée et de y
+    T sy = 0.f, dy = 0.f;           // Corrélations avec y
+    T sd = 0.f;                     // Corrélation de s et de sa dérivée
+    T prev = 0.f;
+    float lambda = 0.f;
+
+    // Constante de temps de la moyenne, en secondes
+    void setTimeConstant(float dt, float tau) {
+        lambda = 1.f - std::exp(-dt / tau);
+    }
+
+    void reset() {
+        ms = my = ss = dd = yy = sy = dy = sd = prev = 0.f;
+    }
+
+    void process(T s, T y) {
+        ms += (s - ms) * lambda;
+        my += (y - my) * lambda;
+        T sc = s - ms;
+        T yc = y - my;
+        T d = sc - prev;
+        prev = sc;
+        ss += (sc * sc - ss) * lambda;
+        dd += (d * d - dd) * lambda;
+        yy += (yc * yc - yy) * lambda;
+        sy += (sc * yc - sy) * lambda;
+        dy += (d * yc - dy) * lambda;
+        sd += (sc * d - sd) * lambda;
+    }
+
+    // Puissance de y cohérente avec le signal d'entrée
+    T coherentPower() const {
+        const float eps = 1e-12f;
+        T a = sd / (ss + eps); // d' = d - a s, orthogonale à s
+        T dyo = dy - a * sy;
+        T ddo = rack::simd::fmax(dd - a * sd, T(0.f));
+        return sy * sy / (ss + eps) + dyo * dyo / (ddo + eps);
+    }
+
+    // Puissance cohérente sur puissance du reste de y
+    T snr() const {
+        T pc = coherentPower();
+        return pc / rack::simd::fmax(yy - pc, T(1e-12f));
+    }
+
+    // Puissance cohérente en sortie sur puissance du signal d'entrée
+    T spa() const {
+        return coherentPower() / (ss + 1e-12f);
+    }
+};
+
+#endif // MESURES_HPP
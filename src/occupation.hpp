@@ -0,0 +1,178 @@
+#ifndef OCCUPATION_HPP
+#define OCCUPATION_HPP
+
+#include <atomic>
+#include <cmath>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+
+// === Occupation des puits et temps d'évasion ===
+
+// Taux d'évasion de Kramers moyen : moyenne exponentielle du nombre de
+// changements de puits par seconde, tous puits confondus. Retombe vers 0 quand
+// la particule reste piégée. T = float ou rack::simd::float_4.
+template <typename T>
+struct EscapeRate {
+    T well = -1.f; // Puits courant (-1 : aucun)
+    T rate = 0.f;  // Évasions par seconde
+    float lambda = 0.f, gain = 0.f;
+
+    // Constante de temps de la moyenne, en secondes
+    void setTimeConstant(float dt, float tau) {
+        lambda = 1.f - std::exp(-dt / tau);
+        gain = lambda / dt;
+    }
+
+    void reset() {
+        well = -1.f;
+        rate = 0.f;
+    }
+
+    void process(T w) {
+        T escaped = rack::simd::ifelse(well >= 0.f, rack::simd::ifelse(w != well, T(gain), T(0.f)), T(0.f));
+        rate += escaped - rate * lambda;
+        well = w;
+    }
+};
+
+// Histogramme de position et temps d'évasion de chaque puits, avec oubli
+// exponentiel, pour l'affichage (thread audio → thread UI).
+// Plutôt que de multiplier toutes les cases par le facteur d'oubli à chaque
+// échantillon, chaque nouvel échantillon reçoit un poids qui croît d'autant ;
+// les cases sont ramenées à l'échelle quand ce poids devient trop grand.
+// Mise à jour en O(1) ; la publication, moins fréquente, copie les cases.
+struct OccupancyHistogram {
+    static const int BINS = 128;
+    static const int MAX_WELLS = 16;
+    static constexpr double RESCALE = 1e30;
+
+    // Publié pour le thread UI
+    struct Snapshot {
+        float lo = -1.f, hi = 1.f;        // Domaine des cases, en V
+        float density[BINS] = {};         // Occupation relative, maximum à 1
+        float escapeTime[MAX_WELLS] = {}; // Durée moyenne avant évasion, s (0 : pas d'évasion)
+        float position[MAX_WELLS] = {};   // Position moyenne dans le puits, V
+    };
+
+    OccupancyHistogram() {
+        for (int b = 0; b < BINS; ++b)
+            shown[b].store(0.f);
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            shownEscape[w].store(0.f);
+            shownPosition[w].store(0.f);
+        }
+        reset();
+    }
+
+    // === Thread audio ===
+
+    void setTimeConstant(float dt, float tau) {
+        growth = std::exp((double)dt / tau);
+        this->dt = dt;
+    }
+
+    // Domaine [lo, hi] ; un changement efface l'histogramme
+    void setRange(float lo, float hi) {
+        if (lo == this->lo && hi == this->hi)
+            return;
+        this->lo = lo;
+        this->hi = hi;
+        invWidth = BINS / (hi - lo);
+        reset();
+    }
+
+    void reset() {
+        weight = 1.0;
+        for (int b = 0; b < BINS; ++b)
+            bins[b] = 0.0;
+        for (int w = 0; w < MAX_WELLS; ++w)
+            escapeSum[w] = escapeCount[w] = positionSum[w] = positionWeight[w] = 0.0;
+        well = -1;
+        dwell = 0.f;
+    }
+
+    // Position x dans le puits w
+    void process(float x, int w) {
+        weight *= growth;
+        if (weight > RESCALE)
+            rescale();
+        int b = (int)std::floor((x - lo) * invWidth);
+        if (b >= 0 && b < BINS)
+            bins[b] += weight;
+        positionSum[w] += weight * x;
+        positionWeight[w] += weight;
+
+        dwell += dt;
+        if (w != well) {
+            if (well >= 0) {
+                escapeSum[well] += weight * dwell;
+                escapeCount[well] += weight;
+            }
+            well = w;
+            dwell = 0.f;
+        }
+    }
+
+    void publish() {
+        double peak = 0.0;
+        for (int b = 0; b < BINS; ++b)
+            peak = std::fmax(peak, bins[b]);
+        float scale = peak > 0.0 ? (float)(1.0 / peak) : 0.f;
+        for (int b = 0; b < BINS; ++b)
+            shown[b].store((float)bins[b] * scale, std::memory_order_relaxed);
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            shownEscape[w].store(escapeCount[w] > 0.0 ? (float)(escapeSum[w] / escapeCount[w]) : 0.f,
+                std::memory_order_relaxed);
+            shownPosition[w].store(positionWeight[w] > 0.0 ? (float)(positionSum[w] / positionWeight[w]) : 0.f,
+                std::memory_order_relaxed);
+        }
+        shownLo.store(lo, std::memory_order_relaxed);
+        shownHi.store(hi, std::memory_order_relaxed);
+    }
+
+    // === Thread UI ===
+
+    // Chaque valeur est cohérente ; l'ensemble peut mêler deux publications
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.lo = shownLo.load(std::memory_order_relaxed);
+        s.hi = shownHi.load(std::memory_order_relaxed);
+        for (int b = 0; b < BINS; ++b)
+            s.density[b] = shown[b].load(std::memory_order_relaxed);
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            s.escapeTime[w] = shownEscape[w].load(std::memory_order_relaxed);
+            s.position[w] = shownPosition[w].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    double growth = 1.0, weight = 1.0;
+    float dt = 1.f / 44100.f;
+    float lo = -1.f, hi = 1.f, invWidth = BINS / 2.f;
+    double bins[BINS];
+    double escapeSum[MAX_WELLS], escapeCount[MAX_WELLS];
+    double positionSum[MAX_WELLS], positionWeight[MAX_WELLS];
+    int well = -1;
+    float dwell = 0.f; // Durée du séjour en cours, s
+
+    std::atomic<float> shown[BINS];
+    std::atomic<float> shownEscape[MAX_WELLS], shownPosition[MAX_WELLS];
+    std::atomic<float> shownLo{-1.f}, shownHi{1.f};
+
+    // Tout est ramené au poids courant, qui repart de 1
+    void rescale() {
+        double r = 1.0 / weight;
+        for (int b = 0; b < BINS; ++b)
+            bins[b] *= r;
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            escapeSum[w] *= r;
+            escapeCount[w] *= r;
+            positionSum[w] *= r;
+            positionWeight[w] *= r;
+        }
+        weight = 1.0;
+    }
+};
+
+#endif // OCCUPATION_HPP
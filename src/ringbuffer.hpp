@@ -0,0 +1,71 @@
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tampon circulaire à un producteur (thread audio) et un consommateur (thread UI).
+// Le producteur écrit sans allocation ni déplacement de données et ne bloque
+// jamais : les échantillons les plus anciens sont écrasés. Le consommateur lit
+// les n derniers échantillons, et écarte ceux écrasés pendant sa copie.
+template <typename T>
+struct RingBuffer {
+    explicit RingBuffer(size_t capacity) {
+        // Capacité arrondie à une puissance de deux
+        size_t c = 1;
+        while (c < capacity)
+            c <<= 1;
+        data.resize(c);
+        mask = c - 1;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Producteur
+    void push(const T& v) {
+        uint64_t w = writeIndex.load(std::memory_order_relaxed);
+        data[w & mask] = v;
+        writeIndex.store(w + 1, std::memory_order_release);
+    }
+
+    // Producteur
+    void clear() {
+        writeIndex.store(0, std::memory_order_release);
+    }
+
+    // Consommateur : copie au plus n derniers éléments, du plus ancien au plus récent.
+    // Retourne le nombre d'éléments valides copiés dans out.
+    size_t snapshot(T* out, size_t n) const {
+        uint64_t w = writeIndex.load(std::memory_order_acquire);
+        if (n > w) n = w;
+        if (n > capacity()) n = capacity();
+        uint64_t start = w - n;
+        for (size_t i = 0; i < n; ++i)
+            out[i] = data[(start + i) & mask];
+
+        // Le producteur a pu réécrire les cases des indices <= w2 - capacité
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t w2 = writeIndex.load(std::memory_order_relaxed);
+        if (w2 < w) return 0; // Remis à zéro pendant la copie
+        uint64_t firstValid = (w2 + 1 > capacity()) ? w2 + 1 - capacity() : 0;
+        if (firstValid <= start) return n;
+        size_t dropped = (size_t)(firstValid - start);
+        if (dropped >= n) return 0;
+        for (size_t i = dropped; i < n; ++i)
+            out[i - dropped] = out[i];
+        return n - dropped;
+    }
+
+private:
+    std::vector<T> data;
+    size_t mask = 0;
+    // Index d'écriture sur sa propre ligne de cache
+    alignas(64) std::atomic<uint64_t> writeIndex{0};
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+#endif // RINGBUFFER_HPP
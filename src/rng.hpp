@@ -0,0 +1,101 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+
+// Générateur xoshiro128** : rapide, 128 bits d'état, un par instance
+struct Xoshiro128 {
+    uint32_t s[4];
+
+    explicit Xoshiro128(uint64_t seed = 0) {
+        this->seed(seed);
+    }
+
+    // Initialisation de l'état par splitmix64
+    void seed(uint64_t seed) {
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            z ^= z >> 31;
+            s[i] = (uint32_t)z;
+            s[i + 1] = (uint32_t)(z >> 32);
+        }
+    }
+
+    uint32_t next() {
+        uint32_t result = rotl(s[1] * 5, 7) * 9;
+        uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 11);
+        return result;
+    }
+
+    // Uniforme dans [0, 1)
+    float uniform() {
+        return (next() >> 8) * (1.f / 16777216.f);
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+};
+
+// Gaussienne N(0, 1) par Box-Muller, calculée par blocs de BLOCK_SIZE
+// échantillons, huit à la fois en float_4, puis servie un par un.
+struct GaussianGenerator {
+    static const int BLOCK_SIZE = 64;
+    Xoshiro128 engine;
+
+    explicit GaussianGenerator(uint64_t seed = 0) : engine(seed) {}
+
+    void seed(uint64_t seed) {
+        engine.seed(seed);
+        index = BLOCK_SIZE;
+    }
+
+    float gaussian() {
+        if (index >= BLOCK_SIZE)
+            refill();
+        return block[index++];
+    }
+
+    // Quatre tirages consécutifs, un par voie
+    rack::simd::float_4 gaussian4() {
+        if (index + 4 > BLOCK_SIZE)
+            refill();
+        rack::simd::float_4 g = rack::simd::float_4::load(&block[index]);
+        index += 4;
+        return g;
+    }
+
+private:
+    float block[BLOCK_SIZE];
+    int index = BLOCK_SIZE;
+
+    void refill() {
+        using rack::simd::float_4;
+        for (int i = 0; i < BLOCK_SIZE; i += 8) {
+            float_4 u1, u2;
+            for (int l = 0; l < 4; ++l) {
+                u1[l] = ((engine.next() >> 8) + 1) * (1.f / 16777216.f); // ]0, 1]
+                u2[l] = engine.uniform();
+            }
+            float_4 r = rack::simd::sqrt(-2.f * rack::simd::log(u1));
+            float_4 theta = (2.f * (float)M_PI) * u2;
+            (r * rack::simd::cos(theta)).store(&block[i]);
+            (r * rack::simd::sin(theta)).store(&block[i + 4]);
+        }
+        index = 0;
+    }
+};
+
+#endif // RNG_HPP
@@ -0,0 +1,145 @@
+#ifndef STATISTIQUES_HPP
+#define STATISTIQUES_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Statistiques d'exécution du module RS, écrites par le thread audio et lues
+// sans verrou par le thread UI. Le thread audio accumule dans des compteurs
+// ordinaires et publie à la cadence de contrôle ; étant le seul écrivain, il
+// publie par simples lectures/écritures atomiques, sans instruction verrouillée.
+struct RSStats {
+    static const int MAX_WELLS = 16;
+
+    // Valeurs publiées, à ne lire que par snapshot()
+    struct Snapshot {
+        double seconds = 0.0;        // Durée couverte
+        double channelSeconds = 0.0; // Somme sur les canaux actifs
+        float nsPerSample = 0.f;     // Coût d'un appel de process(), échantillonné
+        uint64_t transitions = 0;    // Changements de puits, tous canaux
+        uint64_t clampHits = 0;      // Échantillons limités à ±5 V
+        uint64_t nonFinite = 0;      // NaN ou infinis en entrée (la sortie est ramenée dans ±5 V)
+        double residence[MAX_WELLS] = {}; // Temps passé dans chaque puits (canal·s)
+        uint64_t visits[MAX_WELLS] = {};  // Entrées dans chaque puits
+
+        // Changements de puits par seconde et par canal
+        double transitionRate() const {
+            return channelSeconds > 0.0 ? transitions / channelSeconds : 0.0;
+        }
+
+        // Durée moyenne d'un séjour dans le puits w, en secondes
+        double meanResidence(int w) const {
+            return visits[w] ? residence[w] / visits[w] : 0.0;
+        }
+    };
+
+    RSStats() {
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            residence[w].store(0.0);
+            visits[w].store(0);
+        }
+    }
+
+    // === Thread audio ===
+
+    // Coût mesuré d'un échantillon, moyenné exponentiellement
+    void recordTime(float ns) {
+        float avg = nsPerSample.load(std::memory_order_relaxed);
+        nsPerSample.store(avg > 0.f ? avg + (ns - avg) * 0.05f : ns, std::memory_order_relaxed);
+    }
+
+    // Entrée d'un canal dans le puits w depuis prev (-1 : aucun)
+    void recordEntry(int prev, int w) {
+        pending.visits[w]++;
+        if (prev >= 0)
+            pending.transitions++;
+    }
+
+    // Durée (s) passée par un canal dans le puits w
+    void recordStay(int w, double seconds) {
+        pending.residence[w] += seconds;
+    }
+
+    // Séjour de durée dt (s) d'un canal dans le puits w, précédemment prev (-1 : aucun)
+    void recordWell(int prev, int w, float dt) {
+        if (w != prev)
+            recordEntry(prev, w);
+        recordStay(w, dt);
+    }
+
+    void recordSamples(double seconds, double channelSeconds, uint64_t clampHits, uint64_t nonFinite) {
+        pending.seconds += seconds;
+        pending.channelSeconds += channelSeconds;
+        pending.clampHits += clampHits;
+        pending.nonFinite += nonFinite;
+    }
+
+    // Publication des compteurs accumulés, ou remise à zéro demandée par l'UI
+    void publish() {
+        if (resetRequested.exchange(false, std::memory_order_acquire)) {
+            pending = Snapshot();
+            seconds.store(0.0, std::memory_order_relaxed);
+            channelSeconds.store(0.0, std::memory_order_relaxed);
+            nsPerSample.store(0.f, std::memory_order_relaxed);
+            transitions.store(0, std::memory_order_relaxed);
+            clampHits.store(0, std::memory_order_relaxed);
+            nonFinite.store(0, std::memory_order_relaxed);
+            for (int w = 0; w < MAX_WELLS; ++w) {
+                residence[w].store(0.0, std::memory_order_relaxed);
+                visits[w].store(0, std::memory_order_relaxed);
+            }
+            return;
+        }
+        add(seconds, pending.seconds);
+        add(channelSeconds, pending.channelSeconds);
+        add(transitions, pending.transitions);
+        add(clampHits, pending.clampHits);
+        add(nonFinite, pending.nonFinite);
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            if (pending.visits[w] || pending.residence[w] > 0.0) {
+                add(residence[w], pending.residence[w]);
+                add(visits[w], pending.visits[w]);
+            }
+        }
+        pending = Snapshot();
+    }
+
+    // === Thread UI ===
+
+    // Chaque valeur est cohérente ; l'ensemble peut mêler deux publications
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.seconds = seconds.load(std::memory_order_relaxed);
+        s.channelSeconds = channelSeconds.load(std::memory_order_relaxed);
+        s.nsPerSample = nsPerSample.load(std::memory_order_relaxed);
+        s.transitions = transitions.load(std::memory_order_relaxed);
+        s.clampHits = clampHits.load(std::memory_order_relaxed);
+        s.nonFinite = nonFinite.load(std::memory_order_relaxed);
+        for (int w = 0; w < MAX_WELLS; ++w) {
+            s.residence[w] = residence[w].load(std::memory_order_relaxed);
+            s.visits[w] = visits[w].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    void requestReset() {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+private:
+    Snapshot pending; // Accumulé depuis la dernière publication
+
+    std::atomic<double> seconds{0.0}, channelSeconds{0.0};
+    std::atomic<float> nsPerSample{0.f};
+    std::atomic<uint64_t> transitions{0}, clampHits{0}, nonFinite{0};
+    std::atomic<double> residence[MAX_WELLS];
+    std::atomic<uint64_t> visits[MAX_WELLS];
+    std::atomic<bool> resetRequested{false};
+
+    template <typename T, typename U>
+    static void add(std::atomic<T>& a, U v) {
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+};
+
+#endif // STATISTIQUES_HPP
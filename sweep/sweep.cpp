@@ -0,0 +1,533 @@
+// Balayage hors ligne des réglages du module RS, sans Rack ni interface.
+//
+//   make sweep
+//   build/sweep/rssweep --noise 0:2:21 --tau 0.001:0.1:5 --wells 1:4 > courbes.csv
+//
+// Chaque point de la grille (bruit × tau × Xb × N) fait passer la même entrée
+// dans le filtre du module (rsProcess_simd), avec un bruit gaussien blanc ou
+// coloré comme celui du module Noise, et mesure SNR, SPA et transitions entre
+// puits, à poids égaux sur toute la durée après la mise en route. Quatre
+// niveaux de bruit d'un même (tau, Xb, N) partagent un float_4 et la même
+// suite de bruit blanc, tirée d'une graine propre à (tau, Xb, N) : les courbes
+// le long de l'axe du bruit ne portent pas de bruit d'échantillonnage d'un
+// point à l'autre (nombres aléatoires communs). Les groupes sont répartis
+// entre les cœurs par une file à vol de tâches ; le résultat ne dépend pas du
+// nombre de threads.
+//
+// Entrée : --wav FICHIER (première voie, --gain V pour la pleine échelle), ou
+// sinus synthétique --sine HZ --amplitude V --seconds S --rate HZ.
+// Grille : --noise, --tau (s, pas géométrique), --xb en A:B:PAS ou valeur
+// seule, --wells A:B. Pour diode et rubber, --xb donne le seuil et tau, N
+// sont ignorés.
+// Autres : --filter, --integrator, --shape, --asymmetry, --color ALPHA,
+// --warmup S, --threads N, --seed N, --out FICHIER (sinon sortie standard).
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "filtres.hpp"
+#include "bruits.hpp"
+#include "rng.hpp"
+
+using rack::simd::float_4;
+
+static const char* FILTER_NAMES[] = {"none", "diode", "rubber", "multi-well"};
+static const char* INTEGRATOR_NAMES[] = {"euler", "heun", "rk4", "semi-implicit"};
+static const char* POTENTIAL_NAMES[] = {"multi-well", "asymmetric", "tristable", "washboard"};
+
+// === File à vol de tâches ===
+// Chaque thread dépile par la fin de sa propre file et, une fois vide, vole
+// par le début de celle des autres. Les tâches sont distribuées par blocs
+// contigus au départ : les voleurs rééquilibrent quand les coûts diffèrent.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads) : threads(std::max(threads, 1)) {}
+
+    void run(int jobs, const std::function<void(int)>& f) {
+        std::vector<std::unique_ptr<Queue> > queues;
+        for (int t = 0; t < threads; ++t)
+            queues.push_back(std::unique_ptr<Queue>(new Queue));
+        for (int j = 0; j < jobs; ++j)
+            queues[(int64_t)j * threads / jobs]->jobs.push_back(j);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.push_back(std::thread([&queues, &f, t, this]() {
+                int job;
+                while (take(queues, t, job))
+                    f(job);
+            }));
+        }
+        for (std::thread& w : workers)
+            w.join();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<int> jobs;
+    };
+
+    int threads;
+
+    // Aucune tâche n'est ajoutée en cours de route : toutes les files vides, c'est fini
+    bool take(std::vector<std::unique_ptr<Queue> >& queues, int self, int& job) {
+        {
+            Queue& q = *queues[self];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty()) {
+                job = q.jobs.back();
+                q.jobs.pop_back();
+                return true;
+            }
+        }
+        for (int i = 1; i < threads; ++i) {
+            Queue& q = *queues[(self + i) % threads];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty()) {
+                job = q.jobs.front();
+                q.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// === Entrée ===
+
+static uint32_t readLe(const unsigned char* p, int bytes) {
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; ++i)
+        v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+// WAV PCM 8/16/24/32 bits ou flottant 32 bits, première voie, dans [-1, 1]
+static bool readWav(const std::string& path, std::vector<float>& samples, float& sampleRate) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+        data.insert(data.end(), buffer, buffer + n);
+    std::fclose(f);
+    if (data.size() < 12 || std::memcmp(&data[0], "RIFF", 4) || std::memcmp(&data[8], "WAVE", 4))
+        return false;
+
+    int format = 0, channels = 0, bits = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        const unsigned char* chunk = &data[pos];
+        size_t size = readLe(chunk + 4, 4);
+        size_t end = std::min(data.size(), pos + 8 + size);
+        if (!std::memcmp(chunk, "fmt ", 4) && size >= 16) {
+            format = readLe(chunk + 8, 2);
+            channels = readLe(chunk + 10, 2);
+            sampleRate = (float)readLe(chunk + 12, 4);
+            bits = readLe(chunk + 22, 2);
+            if (format == 0xfffe && size >= 26)
+                format = readLe(chunk + 32, 2); // Sous-format de WAVE_FORMAT_EXTENSIBLE
+        } else if (!std::memcmp(chunk, "data", 4) && channels > 0) {
+            int bytes = bits / 8;
+            size_t frame = (size_t)bytes * channels;
+            if (bytes < 1 || bytes > 4 || (format != 1 && !(format == 3 && bits == 32)))
+                return false;
+            for (size_t p = pos + 8; p + frame <= end; p += frame) {
+                uint32_t v = readLe(&data[p], bytes);
+                float x;
+                if (format == 3) {
+                    std::memcpy(&x, &v, sizeof(x));
+                } else if (bytes == 1) {
+                    x = ((int)v - 128) / 128.f;
+                } else {
+                    int shift = 32 - bits;
+                    x = (float)((int32_t)(v << shift) >> shift) / (float)(1u << (bits - 1));
+                }
+                samples.push_back(x);
+            }
+            return !samples.empty();
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// === Grille ===
+
+// "A:B:PAS" ou "A". Pas géométrique si geometric (A et B > 0).
+static bool parseAxis(const char* spec, bool geometric, std::vector<float>& values) {
+    float a, b;
+    int n;
+    values.clear();
+    if (std::sscanf(spec, "%f:%f:%d", &a, &b, &n) == 3 && n >= 1) {
+        if (geometric && (a <= 0.f || b <= 0.f))
+            return false;
+        for (int i = 0; i < n; ++i) {
+            float t = (n > 1) ? (float)i / (n - 1) : 0.f;
+            values.push_back(geometric ? a * std::pow(b / a, t) : a + (b - a) * t);
+        }
+        return true;
+    }
+    if (std::sscanf(spec, "%f", &a) == 1) {
+        values.push_back(a);
+        return !geometric || a > 0.f;
+    }
+    return false;
+}
+
+static int findName(const char* name, const char* const* names, int count) {
+    for (int i = 0; i < count; ++i)
+        if (!std::strcmp(name, names[i]))
+            return i;
+    return -1;
+}
+
+struct Settings {
+    int filter = FILTER_MULTI_WELL;
+    int integrator = INTEGRATOR_EULER;
+    int shape = POTENTIAL_MULTI_WELL;
+    float asymmetry = 0.5f;
+    float color = 0.f;     // Pente du bruit, 1/f^alpha
+    float warmup = 0.5f;   // s, exclues des mesures
+    float sampleRate = 44100.f;
+    uint64_t seed = 1;
+};
+
+struct Point {
+    int N;
+    float tau, xb, noise;
+};
+
+struct Result {
+    float snrDb, spaDb;
+    float transitionRate; // Changements de puits par seconde
+    float meanDwell;      // Durée moyenne d'un séjour, s
+    int wellsVisited;
+    float clampFraction;  // Échantillons limités à ±5 V
+};
+
+// Mesure de SnrMeter (projection sur s et sur sa différence arrière
+// orthogonalisée), mais à poids égaux sur toute la fenêtre : une moyenne
+// exponentielle ne pèserait que sa dernière constante de temps. Sommes
+// partielles en float sur des blocs courts, cumulées en double ; moyennes et
+// covariances calculées à la fin.
+struct WindowSnr {
+    enum Sum { S, Y, D, SS, YY, DD, SY, DY, SD, SUMS };
+    static const int BLOCK = 1024;
+
+    float_4 partial[SUMS];
+    double sums[SUMS][4] = {};
+    float_4 prev = 0.f;
+    bool started = false;
+    int pending = 0;
+    int64_t n = 0;
+
+    WindowSnr() {
+        for (int k = 0; k < SUMS; ++k)
+            partial[k] = 0.f;
+    }
+
+    // Le premier appel ne sert qu'à la différence arrière
+    void process(float_4 s, float_4 y) {
+        float_4 d = s - prev;
+        prev = s;
+        if (!started) {
+            started = true;
+            return;
+        }
+        partial[S] += s;
+        partial[Y] += y;
+        partial[D] += d;
+        partial[SS] += s * s;
+        partial[YY] += y * y;
+        partial[DD] += d * d;
+        partial[SY] += s * y;
+        partial[DY] += d * y;
+        partial[SD] += s * d;
+        if (++pending == BLOCK)
+            flush();
+    }
+
+    void flush() {
+        for (int k = 0; k < SUMS; ++k) {
+            for (int l = 0; l < 4; ++l)
+                sums[k][l] += partial[k][l];
+            partial[k] = 0.f;
+        }
+        n += pending;
+        pending = 0;
+    }
+
+    // SNR et SPA de la voie l ; flush() d'abord
+    void result(int l, double& snr, double& spa) const {
+        const double eps = 1e-12;
+        double m = (double)std::max(n, (int64_t)1);
+        double ms = sums[S][l] / m, my = sums[Y][l] / m, md = sums[D][l] / m;
+        double ss = sums[SS][l] / m - ms * ms;
+        double yy = sums[YY][l] / m - my * my;
+        double dd = sums[DD][l] / m - md * md;
+        double sy = sums[SY][l] / m - ms * my;
+        double dy = sums[DY][l] / m - md * my;
+        double sd = sums[SD][l] / m - ms * md;
+        double a = sd / (ss + eps); // d' = d - a s, orthogonale à s
+        double dyo = dy - a * sy;
+        double ddo = std::max(dd - a * sd, 0.0);
+        double pc = sy * sy / (ss + eps) + dyo * dyo / (ddo + eps);
+        snr = pc / std::max(yy - pc, eps);
+        spa = pc / (ss + eps);
+    }
+};
+
+// Graine propre à (tau, Xb, N), commune à tous les niveaux de bruit du point
+static uint64_t pointSeed(uint64_t seed, const Point& p) {
+    uint32_t tau, xb;
+    std::memcpy(&tau, &p.tau, sizeof(tau));
+    std::memcpy(&xb, &p.xb, sizeof(xb));
+    uint64_t h = seed;
+    const uint64_t keys[] = {tau, xb, (uint64_t)p.N};
+    for (uint64_t key : keys) {
+        // Mélange de splitmix64
+        h += 0x9e3779b97f4a7c15ull + key;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+// Jusqu'à quatre niveaux de bruit d'un même (tau, Xb, N), un par voie, sur la
+// même suite de bruit blanc ; les voies en trop répètent le dernier point
+static void simulate(const Settings& s, const ColoredNoiseFilter& color, const std::vector<float>& input,
+                     const Point* points, int count, Result* results) {
+    float dt = 1.f / s.sampleRate;
+    int N = points[0].N;
+    float tau = points[0].tau, xb = points[0].xb;
+    float_4 amplitude;
+    for (int l = 0; l < 4; ++l)
+        amplitude[l] = points[std::min(l, count - 1)].noise;
+    float_4 h = dt / tau;
+    float_4 g = multi_well_noise_gain(dt, float_4(tau));
+    MultiWellCoefs<float_4> k(N, float_4(xb));
+    k.setAsymmetry(s.asymmetry);
+    bool threshold = (s.filter != FILTER_MULTI_WELL);
+
+    int total = (int)input.size();
+    int warmup = std::min((int)(s.warmup * s.sampleRate), total / 2);
+    float measured = (total - warmup) * dt;
+    WindowSnr meter;
+
+    PotentialKernel<float_4> step = potential_kernel<float_4>(s.shape, k.N, s.integrator);
+    PotentialIndex<float_4> index = potential_index_kernel<float_4>(s.shape, k.N);
+    GaussianGenerator rng(pointSeed(s.seed, points[0]));
+    ColoredNoise<float_4> colored;
+    float_4 x = -1.f;
+    float_4 prev = -1.f, transitions = 0.f, clamps = 0.f;
+    int visited[4] = {0, 0, 0, 0};
+
+    for (int i = 0; i < total; ++i) {
+        // Un seul tirage par échantillon, mis à l'échelle de chaque voie
+        float_4 white = rng.gaussian();
+        float_4 n = (s.color > 0.f) ? colored.process(color, white) : white;
+        n = rack::simd::fmin(rack::simd::fmax(n * amplitude, -5.f), 5.f); // Comme la sortie du module Noise
+        float_4 y = rsProcess_simd(s.filter, step, x, float_4(input[i]), n, float_4(xb), h, g, k);
+        if (i + 1 < warmup)
+            continue;
+        meter.process(float_4(input[i]), y); // Premier appel (i = warmup - 1) : différence seule
+        if (i < warmup)
+            continue;
+
+        float_4 w = threshold ? rack::simd::ifelse(y > 0.f, float_4(1.f), float_4(0.f))
+                              : index(y, k);
+        if (i > warmup)
+            transitions += rack::simd::ifelse(w != prev, float_4(1.f), float_4(0.f));
+        prev = w;
+        clamps += rack::simd::ifelse(rack::simd::fabs(y) >= 5.f, float_4(1.f), float_4(0.f));
+        for (int l = 0; l < 4; ++l)
+            visited[l] |= 1 << (int)w[l];
+    }
+
+    meter.flush();
+    for (int l = 0; l < count; ++l) {
+        Result& r = results[l];
+        double snr, spa;
+        meter.result(l, snr, spa);
+        r.snrDb = 10.f * (float)std::log10(std::max(snr, 1e-10));
+        r.spaDb = 10.f * (float)std::log10(std::max(spa, 1e-10));
+        r.transitionRate = transitions[l] / measured;
+        r.meanDwell = measured / (transitions[l] + 1.f);
+        r.wellsVisited = 0;
+        for (int m = visited[l]; m; m >>= 1)
+            r.wellsVisited += m & 1;
+        r.clampFraction = clamps[l] / (total - warmup);
+    }
+}
+
+int main(int argc, char** argv) {
+    Settings s;
+    std::string wavPath, outPath;
+    float gain = 5.f, sine = 5.f, amplitude = 0.5f, seconds = 10.f;
+    int threads = (int)std::thread::hardware_concurrency();
+    std::vector<float> noises, taus, xbs;
+    parseAxis("0:2:11", false, noises);
+    parseAxis("0.003333", true, taus);
+    parseAxis("1", false, xbs);
+    int nMin = 2, nMax = 2;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = (value != nullptr);
+        if (!ok) {
+        } else if (arg == "--wav") {
+            wavPath = value;
+        } else if (arg == "--gain") {
+            gain = std::atof(value);
+        } else if (arg == "--sine") {
+            sine = std::atof(value);
+        } else if (arg == "--amplitude") {
+            amplitude = std::atof(value);
+        } else if (arg == "--seconds") {
+            seconds = std::atof(value);
+        } else if (arg == "--rate") {
+            s.sampleRate = std::atof(value);
+            ok = s.sampleRate > 0.f;
+        } else if (arg == "--noise") {
+            ok = parseAxis(value, false, noises);
+        } else if (arg == "--tau") {
+            ok = parseAxis(value, true, taus);
+        } else if (arg == "--xb") {
+            ok = parseAxis(value, false, xbs);
+        } else if (arg == "--wells") {
+            int n = std::sscanf(value, "%d:%d", &nMin, &nMax);
+            if (n == 1)
+                nMax = nMin;
+            ok = n >= 1 && nMin >= 1 && nMax >= nMin && nMax <= MULTI_WELL_MAX_N;
+        } else if (arg == "--filter") {
+            s.filter = findName(value, FILTER_NAMES, FILTER_MULTI_WELL + 1);
+            ok = s.filter > FILTER_NONE;
+        } else if (arg == "--integrator") {
+            s.integrator = findName(value, INTEGRATOR_NAMES, INTEGRATORS_LEN);
+            ok = s.integrator >= 0;
+        } else if (arg == "--shape") {
+            s.shape = findName(value, POTENTIAL_NAMES, POTENTIAL_SHAPES_LEN);
+            ok = s.shape >= 0;
+        } else if (arg == "--asymmetry") {
+            s.asymmetry = std::atof(value);
+            ok = std::fabs(s.asymmetry) < 1.f;
+        } else if (arg == "--color") {
+            s.color = std::atof(value);
+            ok = s.color >= 0.f && s.color <= 2.f;
+        } else if (arg == "--warmup") {
+            s.warmup = std::atof(value);
+        } else if (arg == "--threads") {
+            threads = std::atoi(value);
+        } else if (arg == "--seed") {
+            s.seed = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--out") {
+            outPath = value;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "invalid option %s%s%s (see the top of sweep/sweep.cpp)\n",
+                arg.c_str(), value ? " " : "", value ? value : "");
+            return 2;
+        }
+        ++i;
+    }
+
+    // Entrée, en volts
+    std::vector<float> input;
+    if (!wavPath.empty()) {
+        if (!readWav(wavPath, input, s.sampleRate)) {
+            std::fprintf(stderr, "cannot read %s (PCM or 32-bit float WAV)\n", wavPath.c_str());
+            return 1;
+        }
+        for (float& v : input)
+            v *= gain;
+    } else {
+        input.resize((size_t)(seconds * s.sampleRate));
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = amplitude * (float)std::sin(2.0 * M_PI * sine * i / s.sampleRate);
+    }
+    if (input.empty()) {
+        std::fprintf(stderr, "empty input\n");
+        return 1;
+    }
+
+    // Les filtres à seuil n'ont ni tau ni puits
+    if (s.filter != FILTER_MULTI_WELL) {
+        taus.resize(1);
+        nMin = nMax = 1;
+    }
+
+    // Niveaux de bruit groupés par quatre, à (tau, Xb, N) commun
+    std::vector<Point> points;
+    std::vector<int> jobStart, jobEnd;
+    for (int N = nMin; N <= nMax; ++N) {
+        for (float tau : taus) {
+            for (float xb : xbs) {
+                size_t first = points.size();
+                for (float noise : noises)
+                    points.push_back({N, tau, xb, noise});
+                for (size_t p = first; p < points.size(); p += 4) {
+                    jobStart.push_back((int)p);
+                    jobEnd.push_back((int)std::min(p + 4, points.size()));
+                }
+            }
+        }
+    }
+    int jobs = (int)jobStart.size();
+
+    ColoredNoiseFilter color;
+    color.setSlope(s.color, s.sampleRate);
+    std::vector<Result> results(points.size());
+    std::atomic<int> done(0);
+
+    auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+    pool.run(jobs, [&](int j) {
+        int first = jobStart[j];
+        simulate(s, color, input, &points[first], jobEnd[j] - first, &results[first]);
+        int d = ++done;
+        if (d % 64 == 0 || d == jobs)
+            std::fprintf(stderr, "\r%d/%d groups", d, jobs);
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "\n%zu points, %.2f s of input, %.2f s on %d threads\n",
+        points.size(), input.size() / s.sampleRate, elapsed, std::max(threads, 1));
+
+    FILE* out = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    std::fprintf(out, "filter,shape,integrator,N,tau_s,xb,noise_v,snr_db,spa_db,transitions_per_s,mean_dwell_s,"
+                      "wells_visited,clamp_fraction\n");
+    for (size_t p = 0; p < points.size(); ++p) {
+        const Point& pt = points[p];
+        const Result& r = results[p];
+        std::fprintf(out, "%s,%s,%s,%d,%g,%g,%g,%.3f,%.3f,%.4g,%.4g,%d,%.4g\n",
+            FILTER_NAMES[s.filter], s.filter == FILTER_MULTI_WELL ? POTENTIAL_NAMES[s.shape] : "-",
+            s.filter == FILTER_MULTI_WELL ? INTEGRATOR_NAMES[s.integrator] : "-",
+            pt.N, pt.tau, pt.xb, pt.noise, r.snrDb, r.spaDb, r.transitionRate, r.meanDwell,
+            r.wellsVisited, r.clampFraction);
+    }
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}